@@ -0,0 +1,100 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/bulk.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+std::uint64_t work(std::size_t i) {
+    std::uint64_t x = i;
+    for (int k = 0; k < 64; ++k)
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x;
+}
+
+task<> one(thread_pool &pool, std::size_t i, std::uint64_t &result) {
+    co_await pool.schedule();
+    result = work(i);
+}
+
+/// Every job scheduled separately (one queue push and one wake-up attempt each).
+task<std::uint64_t> one_at_a_time(thread_pool &pool, std::size_t n) {
+    std::vector<std::uint64_t> results(n);
+    std::vector<task<>> tasks;
+    tasks.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        tasks.push_back(one(pool, i, results[i]));
+    co_await when_all(tasks);
+    std::uint64_t sum = 0;
+    for (std::uint64_t r : results)
+        sum += r;
+    co_return sum;
+}
+
+/// All the jobs enqueued in one batch.
+task<std::uint64_t> bulk(thread_pool &pool, std::size_t n) {
+    std::uint64_t sum = 0;
+    for (std::uint64_t r : co_await bulk_schedule(pool, n, work))
+        sum += r;
+    co_return sum;
+}
+
+template <typename Submit>
+void run(const char *name, thread_pool &pool, std::size_t n, int rounds, Submit submit) {
+    std::uint64_t check = 0;
+    const auto start = steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        check += sync_await(submit(pool, n));
+    const duration<double> elapsed = steady_clock::now() - start;
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+              << std::setprecision(1)
+              << elapsed.count() * 1e9 / static_cast<double>(n * static_cast<std::size_t>(rounds))
+              << " ns/job (checksum " << check % 1000 << ")\n";
+}
+
+// Usage: bulk_submit [threads] [jobs per batch] [rounds]
+int main(int argc, char *argv[]) {
+    const auto threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto n = argc > 2 ? std::stoul(argv[2]) : 10'000;
+    const int rounds = argc > 3 ? std::stoi(argv[3]) : 100;
+
+    try {
+        thread_pool pool(threads);
+        std::cout << n << " jobs per batch, " << pool.thread_count() << " threads\n";
+        run("one at a time", pool, n, rounds, one_at_a_time);
+        run("bulk_schedule", pool, n, rounds, bulk);
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "load_generator.h"
+#include <mp-coro/async_scope.h>
+#include <mp-coro/fair_thread_pool.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+constexpr std::array<std::uint32_t, 3> weights = {1, 1, 2};
+
+template <typename Schedule, typename Work>
+task<> client(Schedule schedule, const std::atomic<bool> &stop, std::atomic<std::uint64_t> &done,
+              Work work) {
+    while (!stop.load(std::memory_order_relaxed)) {
+        co_await schedule();
+        work();
+        done.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// Tenant 0 is noisy: it runs 8 times more concurrent clients than the others.
+template <typename MakeSchedule, typename Work>
+void run(const char *name, std::size_t threads, duration<double> time, MakeSchedule make_schedule,
+         Work work) {
+    std::array<std::atomic<std::uint64_t>, weights.size()> done {};
+    std::atomic<bool> stop = false;
+    async_scope scope;
+    for (std::size_t tenant = 0; tenant < weights.size(); ++tenant)
+        for (std::size_t i = 0; i < (tenant == 0 ? 16 : 2) * threads; ++i)
+            scope.spawn(client(make_schedule(tenant), stop, done[tenant], work));
+    std::this_thread::sleep_for(time);
+    stop = true;
+    sync_await(scope.join());
+
+    std::uint64_t total = 0;
+    for (auto &d : done)
+        total += d;
+    std::cout << name << '\n';
+    for (std::size_t tenant = 0; tenant < weights.size(); ++tenant)
+        std::cout << "  tenant " << tenant << " (weight " << weights[tenant] << "): " << std::fixed
+                  << std::setprecision(0) << static_cast<double>(done[tenant]) / time.count()
+                  << " req/s, " << std::setprecision(1)
+                  << 100.0 * static_cast<double>(done[tenant]) / static_cast<double>(total)
+                  << "% of the throughput\n";
+}
+
+// Usage: fair_share [threads] [service time in us] [seconds per scenario]
+int main(int argc, char *argv[]) {
+    const auto threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto service = microseconds(argc > 2 ? std::stol(argv[2]) : 10);
+    const auto time = duration<double>(argc > 3 ? std::stod(argv[3]) : 2.0);
+
+    auto work = [service] {
+        const auto end = bench::clock::now() + service;
+        while (bench::clock::now() < end) {}
+    };
+
+    try {
+        {
+            thread_pool pool(threads);
+            run("thread_pool (no isolation)", threads, time,
+                [&](std::size_t) { return [&pool] { return pool.schedule(); }; }, work);
+        }
+        {
+            fair_thread_pool pool(threads, weights);
+            run("fair_thread_pool (weights 1:1:2)", threads, time,
+                [&](std::size_t tenant) {
+                    return [&pool, tenant] { return pool.schedule(tenant); };
+                },
+                work);
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,172 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/mapped_file.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/zero_copy.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+struct fd_guard {
+    int fd;
+    explicit fd_guard(int descriptor) : fd(descriptor) {
+        if (fd < 0)
+            throw std::system_error(errno, std::system_category(), "open");
+    }
+    ~fd_guard() { ::close(fd); }
+};
+
+struct pipe_guard {
+    int fds[2];
+    pipe_guard() {
+        if (::pipe2(fds, O_CLOEXEC) < 0)
+            throw std::system_error(errno, std::system_category(), "pipe2");
+    }
+    ~pipe_guard() {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+};
+
+using copy_fn = mp_coro::task<> (*)(int in, int out, std::uint64_t size, std::size_t chunk);
+
+mp_coro::task<> read_write_loop(int in, int out, std::uint64_t size, std::size_t chunk) {
+    std::vector<char> buffer(chunk);
+    for (std::uint64_t offset = 0; offset < size;)
+        offset += co_await mp_coro::async_blocking([&] {
+            const auto n = ::pread(in, buffer.data(), buffer.size(), static_cast<::off_t>(offset));
+            if (n <= 0 || ::pwrite(out, buffer.data(), static_cast<std::size_t>(n),
+                                   static_cast<::off_t>(offset)) != n)
+                throw std::system_error(errno, std::system_category(), "read/write");
+            return static_cast<std::size_t>(n);
+        });
+}
+
+mp_coro::task<> sendfile_loop(int in, int out, std::uint64_t size, std::size_t chunk) {
+    for (std::uint64_t offset = 0; offset < size;)
+        offset += co_await mp_coro::async_sendfile(out, in, offset, chunk);
+}
+
+mp_coro::task<> splice_loop(int in, int out, std::uint64_t size, std::size_t chunk) {
+    pipe_guard pipe;
+    ::fcntl(pipe.fds[1], F_SETPIPE_SZ, static_cast<int>(chunk)); // best effort
+    for (std::uint64_t offset = 0; offset < size;) {
+        const std::size_t n =
+            co_await mp_coro::async_splice(in, offset, pipe.fds[1], std::nullopt, chunk);
+        for (std::size_t moved = 0; moved < n;)
+            moved += co_await mp_coro::async_splice(pipe.fds[0], std::nullopt, out,
+                                                    offset + moved, n - moved);
+        offset += n;
+    }
+}
+
+mp_coro::task<> copy_file_range_loop(int in, int out, std::uint64_t size, std::size_t chunk) {
+    for (std::uint64_t offset = 0; offset < size;)
+        offset += co_await mp_coro::async_copy_file_range(in, offset, out, offset, chunk);
+}
+
+double cpu_seconds() {
+    ::rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    const auto seconds = [](const ::timeval &tv) {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+void measure(const char *name, copy_fn copy, const std::filesystem::path &from,
+             const std::filesystem::path &to, std::size_t chunk, int rounds) {
+    const auto size = std::filesystem::file_size(from);
+    auto best = duration<double>::max();
+    double best_cpu = 0;
+    for (int r = 0; r < rounds; ++r) {
+        std::filesystem::remove(to);
+        const fd_guard in(::open(from.c_str(), O_RDONLY | O_CLOEXEC));
+        const fd_guard out(::open(to.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644));
+        const auto cpu_start = cpu_seconds();
+        const auto start = steady_clock::now();
+        mp_coro::sync_await(copy(in.fd, out.fd, size, chunk));
+        const duration<double> elapsed = steady_clock::now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+            best_cpu = cpu_seconds() - cpu_start;
+        }
+    }
+    const mp_coro::mapped_file source(from), copied(to);
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(6)
+              << static_cast<double>(size) / best.count() / 1e9 << " GB/s, " << std::setw(6)
+              << best_cpu * 1e3 << " ms CPU"
+              << (source.view() == copied.view() ? "" : " (COPY MISMATCH)") << '\n';
+}
+
+// Usage: file_copy [megabytes] [chunk KiB] [rounds]
+// The source is read from the page cache, so the numbers show the cost of
+// moving the data, not of the disk.
+int main(int argc, char *argv[]) {
+    const std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 256;
+    const std::size_t chunk = (argc > 2 ? std::stoul(argv[2]) : 1024) * 1024;
+    const int rounds = argc > 3 ? std::stoi(argv[3]) : 3;
+
+    // next to each other, as copy_file_range() is limited to one file system
+    const auto from = std::filesystem::current_path() / "mp_coro_file_copy.src";
+    const auto to = std::filesystem::current_path() / "mp_coro_file_copy.dst";
+    try {
+        {
+            std::ofstream out(from, std::ios::binary);
+            std::string block(1 << 20, '\0');
+            for (std::size_t i = 0; i < megabytes; ++i) {
+                for (std::size_t j = 0; j < block.size(); ++j)
+                    block[j] = static_cast<char>((i * 131 + j * 7) % 251);
+                out << block;
+            }
+        }
+
+        std::cout << "copying a " << megabytes << " MB file in chunks of " << chunk / 1024
+                  << " KiB\n";
+        measure("read/write loop", read_write_loop, from, to, chunk, rounds);
+        measure("sendfile", sendfile_loop, from, to, chunk, rounds);
+        measure("splice through a pipe", splice_loop, from, to, chunk, rounds);
+        measure("copy_file_range", copy_file_range_loop, from, to, chunk, rounds);
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+    std::filesystem::remove(from);
+    std::filesystem::remove(to);
+}
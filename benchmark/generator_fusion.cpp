@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/generator.h>
+#include <mp-coro/generator_adaptors.h>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <ranges>
+#include <string>
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+mp_coro::generator<std::uint64_t> iota(std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// A transformation that costs more than the iteration (a 64-bit hash finalizer).
+// `std::views::filter` dereferences the `std::views::transform` iterator for the
+// predicate and again for the consumer, so `mix` runs twice for every element
+// that gets through; the fused chain calls it once.
+constexpr auto mix = [](std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    x = (x ^ (x >> 31)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+};
+constexpr auto by7 = [](std::uint64_t x) { return x % 7 != 0; };
+constexpr auto by11 = [](std::uint64_t x) { return x % 11 != 0; };
+
+template <typename F>
+void measure(const char *name, std::uint64_t n, int rounds, F f) {
+    std::uint64_t result = 0;
+    auto best = duration<double>::max();
+    for (int r = 0; r < rounds; ++r) {
+        const auto start = steady_clock::now();
+        result = f(n);
+        best = std::min<duration<double>>(best, steady_clock::now() - start);
+    }
+    std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed
+              << std::setprecision(2) << best.count() * 1e9 / static_cast<double>(n)
+              << " ns/element (result " << result << ")\n";
+}
+
+// Usage: generator_fusion [elements] [rounds]
+int main(int argc, char *argv[]) {
+    const std::uint64_t n = argc > 1 ? std::stoull(argv[1]) : 10'000'000;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::cout << "sum of the hashes passing two filters, " << n << " elements\n";
+    measure("hand-written loop", n, rounds, [](std::uint64_t count) {
+        std::uint64_t sum = 0;
+        for (std::uint64_t i = 0; i < count; ++i)
+            if (const auto x = mix(i); by7(x) && by11(x))
+                sum += x;
+        return sum;
+    });
+    measure("hand-written generator loop", n, rounds, [](std::uint64_t count) {
+        std::uint64_t sum = 0;
+        for (const auto i : iota(count))
+            if (const auto x = mix(i); by7(x) && by11(x))
+                sum += x;
+        return sum;
+    });
+    measure("std::views over a generator", n, rounds, [](std::uint64_t count) {
+        std::uint64_t sum = 0;
+        for (const auto x : iota(count) | std::views::transform(mix) |
+                                std::views::filter(by7) | std::views::filter(by11))
+            sum += x;
+        return sum;
+    });
+    measure("fused adaptors", n, rounds, [](std::uint64_t count) {
+        std::uint64_t sum = 0;
+        for (const auto x :
+             iota(count) | fused::map(mix) | fused::filter(by7) | fused::filter(by11))
+            sum += x;
+        return sum;
+    });
+}
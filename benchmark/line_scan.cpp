@@ -0,0 +1,147 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/mapped_file.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace std::chrono;
+
+// Lines of 0 to 160 characters (80 on average).
+void write_log(const std::filesystem::path &path, std::size_t bytes) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::size_t> length(0, 160);
+    std::ofstream out(path, std::ios::binary);
+    std::string line;
+    for (std::size_t written = 0; written < bytes; written += line.size() + 1) {
+        line.assign(length(rng), 'x');
+        out << line << '\n';
+    }
+}
+
+struct result {
+    std::size_t lines = 0;
+    std::size_t chars = 0;
+};
+
+result memchr_lines(std::string_view text) {
+    result r;
+    const char *line = text.data();
+    const char *const end = line + text.size();
+    while (const void *nl = std::memchr(line, '\n', static_cast<std::size_t>(end - line))) {
+        const char *newline = static_cast<const char *>(nl);
+        ++r.lines;
+        r.chars += static_cast<std::size_t>(newline - line);
+        line = newline + 1;
+    }
+    return r;
+}
+
+template <typename F>
+void measure(const char *name, std::uintmax_t bytes, int rounds, F f) {
+    result r;
+    auto best = duration<double>::max();
+    for (int i = 0; i < rounds; ++i) {
+        const auto start = steady_clock::now();
+        r = f();
+        best = std::min<duration<double>>(best, steady_clock::now() - start);
+    }
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(7)
+              << static_cast<double>(bytes) / best.count() / 1e9 << " GB/s (" << r.lines
+              << " lines, " << r.chars << " chars)\n";
+}
+
+// Usage: line_scan [megabytes] [rounds]
+// The file is read from the page cache after the first round, so the numbers
+// show the cost of the scanning, not of the disk.
+int main(int argc, char *argv[]) {
+    const std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 256;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    const auto path = std::filesystem::temp_directory_path() / "mp_coro_line_scan.log";
+    write_log(path, megabytes << 20);
+    const auto bytes = std::filesystem::file_size(path);
+    std::cout << "counting the lines of a " << megabytes << " MB file, newline search on "
+              << mp_coro::detail::newline_block << "-byte blocks\n";
+
+    measure("std::getline(std::ifstream)", bytes, rounds, [&] {
+        result r;
+        std::ifstream in(path, std::ios::binary);
+        for (std::string line; std::getline(in, line); ++r.lines)
+            r.chars += line.size();
+        return r;
+    });
+    measure("istreambuf_iterator", bytes, rounds, [&] {
+        result r;
+        std::ifstream in(path, std::ios::binary);
+        std::size_t length = 0;
+        for (auto it = std::istreambuf_iterator<char>(in); it != std::istreambuf_iterator<char>();
+             ++it) {
+            if (*it == '\n') {
+                ++r.lines;
+                r.chars += std::exchange(length, 0);
+            } else
+                ++length;
+        }
+        return r;
+    });
+    measure("std::memchr over mapped_file", bytes, rounds, [&] {
+        const mp_coro::mapped_file file(path);
+        return memchr_lines(file.view());
+    });
+    measure("mapped_lines()", bytes, rounds, [&] {
+        result r;
+        for (std::string_view line : mp_coro::mapped_lines(path)) {
+            ++r.lines;
+            r.chars += line.size();
+        }
+        return r;
+    });
+
+
+    // the same mapping scanned repeatedly: no page faults, only the search
+    const mp_coro::mapped_file file(path);
+    std::cout << "scanning an already mapped file\n";
+    measure("std::memchr", bytes, rounds, [&] { return memchr_lines(file.view()); });
+    measure("lines()", bytes, rounds, [&] {
+        result r;
+        for (std::string_view line : mp_coro::lines(file.view())) {
+            ++r.lines;
+            r.chars += line.size();
+        }
+        return r;
+    });
+
+    std::filesystem::remove(path);
+}
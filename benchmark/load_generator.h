@@ -0,0 +1,254 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/concepts.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <string_view>
+#include <thread>
+
+namespace mp_coro::bench {
+
+using clock = std::chrono::steady_clock;
+
+/// Lock-free log-linear histogram of latencies in nanoseconds.
+///
+/// Every power-of-two range is split into 32 linear sub-buckets, which bounds
+/// the relative error of the reported percentiles to ~3% over the full
+/// `std::uint64_t` range.
+class latency_histogram {
+    static constexpr unsigned sub_bucket_bits = 5;
+    static constexpr std::uint64_t sub_bucket_count = 1u << sub_bucket_bits;
+    static constexpr std::size_t bucket_count = (64 - sub_bucket_bits) * sub_bucket_count;
+
+    static constexpr std::size_t bucket_index(std::uint64_t v) noexcept {
+        if (v < 2 * sub_bucket_count)
+            return static_cast<std::size_t>(v);
+        const auto shift = static_cast<unsigned>(std::bit_width(v)) - (sub_bucket_bits + 1);
+        return static_cast<std::size_t>(shift * sub_bucket_count + (v >> shift));
+    }
+
+    /// Largest value that falls into the bucket with the given index.
+    static constexpr std::uint64_t bucket_upper_bound(std::size_t index) noexcept {
+        if (index < 2 * sub_bucket_count)
+            return index;
+        const auto shift = index / sub_bucket_count - 1;
+        const auto mantissa = index % sub_bucket_count + sub_bucket_count;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+  public:
+    void record(std::chrono::nanoseconds latency) noexcept {
+        const auto v = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+        buckets_[bucket_index(v)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        auto max = max_.load(std::memory_order_relaxed);
+        while (v > max && !max_.compare_exchange_weak(max, v, std::memory_order_relaxed)) {}
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::chrono::nanoseconds max() const noexcept {
+        return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+    }
+
+    /// Returns the (upper bound of the) latency below which the fraction @p q
+    /// of all the recorded samples fall.
+    [[nodiscard]] std::chrono::nanoseconds percentile(double q) const noexcept {
+        const auto total = count();
+        if (total == 0)
+            return {};
+        const auto rank = std::max<std::uint64_t>(
+            static_cast<std::uint64_t>(q * static_cast<double>(total) + 0.5), 1);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::chrono::nanoseconds(
+                    std::min(bucket_upper_bound(i), max_.load(std::memory_order_relaxed)));
+        }
+        return max();
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_ {};
+    std::atomic<std::uint64_t> count_ = 0;
+    std::atomic<std::uint64_t> max_ = 0;
+};
+
+/// Distribution of the inter-arrival times of the generated requests.
+enum class arrival {
+    constant, ///< Requests arrive exactly every `1 / rate` seconds.
+    poisson   ///< Exponentially distributed inter-arrival times with mean `1 / rate`.
+};
+
+struct load_config {
+    double rate = 1000;                          ///< Requests per second.
+    std::chrono::nanoseconds duration = std::chrono::seconds(1);
+    arrival process = arrival::constant;
+    std::uint64_t seed = 42;
+};
+
+struct load_report {
+    latency_histogram latency;
+    std::uint64_t requests = 0;
+    std::chrono::nanoseconds elapsed {}; ///< From the first intended start to the last completion.
+
+    [[nodiscard]] double throughput() const noexcept {
+        return elapsed.count() ? static_cast<double>(requests) * 1e9
+                                     / static_cast<double>(elapsed.count())
+                               : 0.0;
+    }
+};
+
+namespace detail {
+
+/// Eagerly started coroutine that destroys itself on completion.
+struct detached_request {
+    struct promise_type {
+        detached_request get_return_object() noexcept { return {}; }
+        static std::suspend_never initial_suspend() noexcept { return {}; }
+        static std::suspend_never final_suspend() noexcept { return {}; }
+        static void return_void() noexcept {}
+        static void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+struct request_sync {
+    std::atomic<std::uint64_t> outstanding = 0;
+    std::atomic<clock::time_point::rep> last_completion = 0;
+
+    void complete(clock::time_point now) noexcept {
+        auto last = last_completion.load(std::memory_order_relaxed);
+        const auto rep = now.time_since_epoch().count();
+        while (rep > last
+               && !last_completion.compare_exchange_weak(last, rep, std::memory_order_relaxed)) {}
+        if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            outstanding.notify_all();
+    }
+
+    void wait() noexcept {
+        for (auto n = outstanding.load(std::memory_order_acquire); n != 0;
+             n = outstanding.load(std::memory_order_acquire))
+            outstanding.wait(n, std::memory_order_acquire);
+    }
+};
+
+/// A single request: hops onto the scheduler, does the work, and records the
+/// latency measured from the time the request was *intended* to start, which
+/// accounts for the queueing delay the load generator itself may have
+/// suffered (no coordinated omission).
+template <scheduler S, std::invocable Work>
+detached_request request(S &sched, Work &work, clock::time_point intended,
+                         latency_histogram &hist, request_sync &sync) {
+    co_await sched.schedule();
+    work();
+    const auto now = clock::now();
+    hist.record(now - intended);
+    sync.complete(now);
+}
+
+inline void wait_until(clock::time_point t) {
+    using namespace std::chrono_literals;
+    if (t - clock::now() > 200us)
+        std::this_thread::sleep_until(t - 100us);
+    while (clock::now() < t) {} // spin for the rest to keep the schedule accurate
+}
+
+} // namespace detail
+
+/// Open-loop load generator: injects requests executing @p work into
+/// @p sched at the rate given by @p config, independently of how fast they
+/// complete, and waits for all of them to finish.
+template <scheduler S, std::invocable Work>
+void run_open_loop(S &sched, const load_config &config, Work work, load_report &report) {
+    std::mt19937_64 rng(config.seed);
+    std::exponential_distribution<double> exp_dist(config.rate);
+    const auto period = std::chrono::duration<double>(1.0 / config.rate);
+
+    detail::request_sync sync;
+    const auto start = clock::now();
+    const auto stop = start + config.duration;
+    auto intended = start;
+    std::uint64_t requests = 0;
+    while (intended < stop) {
+        detail::wait_until(intended);
+        sync.outstanding.fetch_add(1, std::memory_order_relaxed);
+        detail::request(sched, work, intended, report.latency, sync);
+        ++requests;
+        const auto gap = config.process == arrival::poisson
+                           ? std::chrono::duration<double>(exp_dist(rng))
+                           : period;
+        intended += std::chrono::duration_cast<clock::duration>(gap);
+    }
+    sync.wait();
+    report.requests = requests;
+    report.elapsed = clock::time_point(clock::duration(sync.last_completion.load())) - start;
+}
+
+/// Closed burst: submits @p requests requests back-to-back and measures the
+/// rate at which the scheduler completes them, i.e. its throughput at
+/// saturation.
+template <scheduler S, std::invocable Work>
+void run_saturation(S &sched, std::uint64_t requests, Work work, load_report &report) {
+    detail::request_sync sync;
+    sync.outstanding.store(requests, std::memory_order_relaxed);
+    const auto start = clock::now();
+    for (std::uint64_t i = 0; i < requests; ++i)
+        detail::request(sched, work, start, report.latency, sync);
+    sync.wait();
+    report.requests = requests;
+    report.elapsed = clock::time_point(clock::duration(sync.last_completion.load())) - start;
+}
+
+inline void print_header(std::ostream &os) {
+    os << std::left << std::setw(28) << "scenario" << std::right << std::setw(12) << "req/s"
+       << std::setw(12) << "p50 [us]" << std::setw(12) << "p99 [us]" << std::setw(12)
+       << "p99.9 [us]" << std::setw(12) << "max [us]" << '\n';
+}
+
+inline void print_report(std::ostream &os, std::string_view name, const load_report &report) {
+    const auto us = [](std::chrono::nanoseconds ns) {
+        return std::chrono::duration<double, std::micro>(ns).count();
+    };
+    const auto &h = report.latency;
+    os << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+       << std::setw(12) << report.throughput() << std::setw(12) << us(h.percentile(0.5))
+       << std::setw(12) << us(h.percentile(0.99)) << std::setw(12) << us(h.percentile(0.999))
+       << std::setw(12) << us(h.max()) << '\n';
+}
+
+} // namespace mp_coro::bench
@@ -0,0 +1,141 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/parallel.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/thread_pool.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef MP_CORO_BENCHMARK_PAR_EXECUTION
+#include <execution>
+#endif
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+template <typename F>
+void measure(const char *name, int rounds, F f) {
+    double result = 0;
+    auto best = duration<double>::max();
+    for (int r = 0; r < rounds; ++r) {
+        const auto start = steady_clock::now();
+        result = f();
+        best = std::min<duration<double>>(best, steady_clock::now() - start);
+    }
+    std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed
+              << std::setprecision(2) << best.count() * 1e3 << " ms (result "
+              << std::setprecision(6) << result << ")\n";
+}
+
+// a transformation heavy enough to be compute-bound
+double heavy(double x) { return std::sqrt(x) * std::log1p(x); }
+
+// Usage: parallel_algorithms [threads] [elements] [rounds]
+int main(int argc, char *argv[]) {
+    const auto threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto n = argc > 2 ? std::stoul(argv[2]) : 100'000'000;
+    const int rounds = argc > 3 ? std::stoi(argv[3]) : 5;
+
+    thread_pool pool(threads);
+    std::vector<double> in(n);
+    std::iota(in.begin(), in.end(), 0.0);
+    std::vector<double> out(n);
+    std::cout << n << " elements, " << pool.thread_count() << " threads, best of " << rounds
+              << " rounds\n";
+
+    std::cout << "transform_reduce (sum of squares)\n";
+    const auto square = [](double x) { return x * x; };
+    measure("sequential", rounds, [&] {
+        return std::transform_reduce(in.begin(), in.end(), 0.0, std::plus<>(), square);
+    });
+#ifdef MP_CORO_BENCHMARK_PAR_EXECUTION
+    measure("std::execution::par", rounds, [&] {
+        return std::transform_reduce(std::execution::par, in.begin(), in.end(), 0.0,
+                                     std::plus<>(), square);
+    });
+#endif
+    measure("parallel_transform_reduce", rounds, [&] {
+        return sync_await(parallel_transform_reduce(pool, in, 0.0, std::plus<>(), square));
+    });
+
+    std::cout << "transform (sqrt(x) * log1p(x))\n";
+    measure("sequential", rounds, [&] {
+        std::transform(in.begin(), in.end(), out.begin(), heavy);
+        return out.back();
+    });
+#ifdef MP_CORO_BENCHMARK_PAR_EXECUTION
+    measure("std::execution::par", rounds, [&] {
+        std::transform(std::execution::par, in.begin(), in.end(), out.begin(), heavy);
+        return out.back();
+    });
+#endif
+    measure("parallel_transform", rounds, [&] {
+        const auto end = sync_await(parallel_transform(pool, in, out.begin(), heavy));
+        return end[-1];
+    });
+
+    std::cout << "for_each (x = heavy(x))\n";
+    const auto update = [](double &x) { x = heavy(x); };
+    measure("sequential", rounds, [&] {
+        std::for_each(out.begin(), out.end(), update);
+        return out.back();
+    });
+#ifdef MP_CORO_BENCHMARK_PAR_EXECUTION
+    measure("std::execution::par", rounds, [&] {
+        std::for_each(std::execution::par, out.begin(), out.end(), update);
+        return out.back();
+    });
+#endif
+    measure("parallel_for_each", rounds, [&] {
+        sync_await(parallel_for_each(pool, out, update));
+        return out.back();
+    });
+
+    // fixed grain sizes suit either small or large inputs, lazy splitting both
+    for (const std::size_t size : {std::size_t {10'000}, n}) {
+        const std::span<const double> input(in.data(), std::min(size, n));
+        const auto reps = std::max<std::size_t>(n / input.size(), 1);
+        std::cout << "transform_reduce (sqrt(x) * log1p(x)), " << reps << " x " << input.size()
+                  << " elements\n";
+        for (const std::size_t grain : {std::size_t {64}, std::size_t {65'536}, auto_grain}) {
+            const std::string name =
+                grain == auto_grain ? "auto (lazy splitting)" : "grain " + std::to_string(grain);
+            measure(name.c_str(), rounds, [&] {
+                double sum = 0;
+                for (std::size_t r = 0; r < reps; ++r)
+                    sum += sync_await(
+                        parallel_transform_reduce(pool, input, 0.0, std::plus<>(), heavy, grain));
+                return sum;
+            });
+        }
+    }
+}
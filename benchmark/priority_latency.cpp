@@ -0,0 +1,92 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "load_generator.h"
+#include <mp-coro/async_scope.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+/// Schedules on the pool with the given priority.
+struct prioritized {
+    thread_pool &pool;
+    priority prio;
+    thread_pool::schedule_operation schedule() noexcept { return pool.schedule(prio); }
+};
+
+template <typename Work>
+task<> background(thread_pool &pool, const std::atomic<bool> &stop, Work work) {
+    while (!stop.load(std::memory_order_relaxed)) {
+        co_await pool.schedule(priority::low);
+        work();
+    }
+}
+
+// Usage: priority_latency [threads] [service time in us] [seconds per scenario]
+//
+// Keeps all the workers busy with low priority batch work, and measures the
+// latency of requests arriving at 10% of the pool capacity with each priority.
+int main(int argc, char *argv[]) {
+    const auto threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto service = microseconds(argc > 2 ? std::stol(argv[2]) : 10);
+    const auto seconds = duration<double>(argc > 3 ? std::stod(argv[3]) : 2.0);
+
+    auto work = [service] {
+        const auto end = bench::clock::now() + service;
+        while (bench::clock::now() < end) {}
+    };
+
+    try {
+        thread_pool pool(threads);
+        std::cout << "thread_pool: " << pool.thread_count() << " threads, " << service.count()
+                  << " us of work per request, saturated with low priority work\n";
+        bench::print_header(std::cout);
+
+        const double rate =
+            0.1 * static_cast<double>(pool.thread_count()) / duration<double>(service).count();
+        for (const auto prio : {priority::high, priority::normal, priority::low}) {
+            std::atomic<bool> stop = false;
+            async_scope scope;
+            for (std::size_t i = 0; i < 4 * pool.thread_count(); ++i)
+                scope.spawn(background(pool, stop, work));
+
+            bench::load_report report;
+            prioritized sched {pool, prio};
+            bench::run_open_loop(sched, {rate, duration_cast<nanoseconds>(seconds)}, work, report);
+            const char *names[] = {"high", "normal", "low"};
+            bench::print_report(std::cout, std::string(names[static_cast<int>(prio)]) + " priority",
+                                report);
+
+            stop = true;
+            sync_await(scope.join());
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "load_generator.h"
+#include <mp-coro/thread_pool.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Usage: scheduler_latency [threads] [service time in us] [seconds per scenario]
+int main(int argc, char *argv[]) {
+    using namespace mp_coro;
+    using namespace std::chrono;
+
+    const auto threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto service = microseconds(argc > 2 ? std::stol(argv[2]) : 10);
+    const auto seconds = duration<double>(argc > 3 ? std::stod(argv[3]) : 2.0);
+    const auto scenario_duration = duration_cast<nanoseconds>(seconds);
+
+    auto work = [service] {
+        const auto end = bench::clock::now() + service;
+        while (bench::clock::now() < end) {}
+    };
+
+    try {
+        thread_pool pool(threads);
+        std::cout << "thread_pool: " << pool.thread_count() << " threads, " << service.count()
+                  << " us of work per request\n";
+        bench::print_header(std::cout);
+
+        double capacity = 0;
+        {
+            bench::load_report report;
+            const auto requests = static_cast<std::uint64_t>(
+                scenario_duration / service * static_cast<long>(pool.thread_count()));
+            bench::run_saturation(pool, std::max<std::uint64_t>(requests, 1000), work, report);
+            bench::print_report(std::cout, "saturation", report);
+            capacity = report.throughput();
+        }
+
+        for (const double load : {0.5, 0.8, 0.95}) {
+            for (const auto process : {bench::arrival::constant, bench::arrival::poisson}) {
+                bench::load_report report;
+                const bench::load_config config {load * capacity, scenario_duration, process};
+                bench::run_open_loop(pool, config, work, report);
+                const auto name =
+                    std::string(process == bench::arrival::constant ? "constant" : "poisson")
+                    + " @ " + std::to_string(static_cast<int>(load * 100)) + "%";
+                bench::print_report(std::cout, name, report);
+            }
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
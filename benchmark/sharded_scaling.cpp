@@ -0,0 +1,129 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/async_scope.h>
+#include <mp-coro/sharded_runtime.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace mp_coro;
+using namespace std::chrono;
+
+constexpr std::size_t clients_per_thread = 64;
+
+struct counters {
+    std::atomic<bool> stop = false;
+    std::atomic<std::uint64_t> ops = 0;
+};
+
+/// Reschedules itself on the pool (shared queues, stealing).
+task<> pool_client(thread_pool &pool, counters &c) {
+    std::uint64_t ops = 0;
+    while (!c.stop.load(std::memory_order_relaxed)) {
+        co_await pool.schedule();
+        ++ops;
+    }
+    c.ops += ops;
+}
+
+/// Reschedules itself on its own shard.
+task<> local_client(sharded_runtime &rt, std::size_t shard, counters &c) {
+    co_await rt.schedule(shard);
+    std::uint64_t ops = 0;
+    while (!c.stop.load(std::memory_order_relaxed)) {
+        co_await rt.schedule(shard);
+        ++ops;
+    }
+    c.ops += ops;
+}
+
+/// Round trips to the next shard through the mailboxes.
+task<> cross_client(sharded_runtime &rt, std::size_t shard, counters &c) {
+    co_await rt.schedule(shard);
+    const std::size_t next = (shard + 1) % rt.shard_count();
+    std::uint64_t ops = 0;
+    while (!c.stop.load(std::memory_order_relaxed)) {
+        co_await rt.submit_to(next, [] {});
+        ++ops;
+    }
+    c.ops += ops;
+}
+
+template <typename Spawn>
+double measure(std::size_t threads, duration<double> time, Spawn spawn) {
+    counters c;
+    async_scope scope;
+    for (std::size_t i = 0; i < threads * clients_per_thread; ++i)
+        scope.spawn(spawn(i % threads, c));
+    std::this_thread::sleep_for(time);
+    c.stop = true;
+    sync_await(scope.join());
+    return static_cast<double>(c.ops.load()) / time.count();
+}
+
+// Usage: sharded_scaling [max threads] [seconds per scenario]
+//
+// Throughput of rescheduling coroutines for a growing number of threads:
+// thread_pool, sharded_runtime with work staying on its shard, and
+// sharded_runtime with every operation being a round trip to another shard.
+int main(int argc, char *argv[]) {
+    const auto max_threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    const auto seconds = duration<double>(argc > 2 ? std::stod(argv[2]) : 1.0);
+
+    try {
+        std::cout << std::setw(8) << "threads" << std::setw(20) << "thread_pool [op/s]"
+                  << std::setw(20) << "local [op/s]" << std::setw(20) << "cross [op/s]" << '\n';
+        for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+            double pool_rate = 0;
+            {
+                thread_pool pool(threads);
+                pool_rate = measure(threads, seconds, [&](std::size_t, counters &c) {
+                    return pool_client(pool, c);
+                });
+            }
+            double local_rate = 0;
+            double cross_rate = 0;
+            {
+                sharded_runtime rt(threads);
+                local_rate = measure(threads, seconds, [&](std::size_t shard, counters &c) {
+                    return local_client(rt, shard, c);
+                });
+                cross_rate = measure(threads, seconds, [&](std::size_t shard, counters &c) {
+                    return cross_client(rt, shard, c);
+                });
+            }
+            std::cout << std::setw(8) << threads << std::fixed << std::setprecision(0)
+                      << std::setw(20) << pool_rate << std::setw(20) << local_rate
+                      << std::setw(20) << cross_rate << '\n';
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
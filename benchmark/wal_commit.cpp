@@ -0,0 +1,123 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/async_wal.h>
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/when_all.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+const std::string record(100, 'r');
+
+// baseline: every record is written and synced on its own
+struct sync_per_record_log {
+    int fd;
+    std::mutex mutex;
+    std::uint64_t end = 0;
+    std::uint64_t syncs = 0;
+
+    explicit sync_per_record_log(const std::filesystem::path &path)
+        : fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) {
+        if (fd < 0)
+            throw std::system_error(errno, std::system_category(), "open");
+    }
+    ~sync_per_record_log() { ::close(fd); }
+
+    auto append(std::string_view data) {
+        return mp_coro::async_blocking([this, data] {
+            std::lock_guard lock(mutex);
+            if (::pwrite(fd, data.data(), data.size(), static_cast<::off_t>(end)) < 0 ||
+                ::fdatasync(fd) < 0)
+                throw std::system_error(errno, std::system_category(), "append");
+            end += data.size();
+            ++syncs;
+        });
+    }
+};
+
+template <typename Log>
+mp_coro::task<> writer(Log &log, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i)
+        co_await log.append(record);
+}
+
+template <typename Log>
+void run(Log &log, std::size_t writers, std::size_t records) {
+    std::vector<mp_coro::task<>> tasks;
+    for (std::size_t i = 0; i < writers; ++i)
+        tasks.push_back(writer(log, records / writers));
+    mp_coro::sync_await(when_all(tasks));
+}
+
+void report(const char *name, std::size_t writers, std::size_t records, std::uint64_t syncs,
+            duration<double> elapsed) {
+    std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(4)
+              << writers << " writers: " << std::setw(9) << std::fixed << std::setprecision(0)
+              << static_cast<double>(records) / elapsed.count() << " records/s, "
+              << std::setw(5) << syncs << " syncs\n";
+}
+
+// Usage: wal_commit [records]
+int main(int argc, char *argv[]) {
+    const std::size_t records = argc > 1 ? std::stoul(argv[1]) : 2048;
+    const auto path = std::filesystem::current_path() / "mp_coro_wal_commit.log";
+
+    std::cout << "durable appends of " << records << " records of " << record.size()
+              << " bytes\n";
+    try {
+        for (const std::size_t writers : {1U, 8U, 64U, 256U}) {
+            {
+                sync_per_record_log log(path);
+                const auto start = steady_clock::now();
+                run(log, writers, records);
+                report("sync per record", writers, records, log.syncs,
+                       steady_clock::now() - start);
+            }
+            std::filesystem::remove(path);
+            {
+                mp_coro::async_wal wal(path);
+                const auto start = steady_clock::now();
+                run(wal, writers, records);
+                report("async_wal", writers, records, wal.syncs(), steady_clock::now() - start);
+            }
+            std::filesystem::remove(path);
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/async_scope.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <syncstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+mp_coro::task<> flush(int batch) {
+    std::this_thread::sleep_for(100ms);
+    std::osyncstream(std::cout) << "flushed batch #" << batch << '\n';
+    co_return;
+}
+
+mp_coro::task<> failing_flush() {
+    throw std::runtime_error("disk full");
+    co_return;
+}
+
+mp_coro::task<> process(mp_coro::thread_pool &pool) {
+    mp_coro::async_scope scope;
+    for (int batch = 0; batch < 3; ++batch) {
+        std::osyncstream(std::cout) << "processing batch #" << batch << '\n';
+        scope.spawn(pool, flush(batch)); // runs in the background
+    }
+    std::osyncstream(std::cout) << "waiting for the flushes\n";
+    co_await scope.join();
+    std::osyncstream(std::cout) << "all flushed\n";
+
+    scope.spawn(pool, failing_flush());
+    try {
+        co_await scope.join();
+    } catch (const std::exception &ex) {
+        std::osyncstream(std::cout) << "flush failed: " << ex.what() << '\n';
+    }
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool pool(2);
+        mp_coro::sync_await(process(pool));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,69 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/async_wal.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// a client committing its transactions one after another
+mp_coro::task<> client(mp_coro::thread_pool &pool, mp_coro::async_wal &wal, int id) {
+    co_await pool.schedule();
+    for (int tx = 0; tx < 5; ++tx) {
+        // records framed as text lines, so that the log can be read back
+        const std::string record =
+            "client " + std::to_string(id) + " tx " + std::to_string(tx) + '\n';
+        co_await wal.append(record); // durable from now on
+    }
+}
+
+int main() {
+    const auto path = std::filesystem::current_path() / "mp_coro_async_wal.log";
+    try {
+        std::filesystem::remove(path);
+        mp_coro::thread_pool pool(4);
+        mp_coro::async_wal wal(path);
+
+        std::vector<mp_coro::task<>> clients;
+        for (int id = 0; id < 20; ++id)
+            clients.push_back(client(pool, wal, id));
+        mp_coro::sync_await(when_all(clients));
+        std::cout << wal.records() << " records made durable with " << wal.syncs()
+                  << " syncs\n";
+
+        std::ifstream log(path);
+        const auto lines = std::count(std::istreambuf_iterator<char>(log),
+                                      std::istreambuf_iterator<char>(), '\n');
+        std::cout << lines << " records in the log\n";
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,69 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/schedule_on.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <syncstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+// a legacy synchronous API
+std::string read_record(int id) {
+    std::this_thread::sleep_for(100ms);
+    return "record " + std::to_string(id);
+}
+
+mp_coro::task<std::size_t> handle(mp_coro::thread_pool &compute, mp_coro::blocking_pool &blocking,
+                                  int id) {
+    co_await compute.schedule();
+    // the compute worker is released while the call blocks
+    const std::string record =
+        co_await (mp_coro::async_blocking(blocking, [id] { return read_record(id); }) |
+                  mp_coro::resume_on(compute));
+    std::osyncstream(std::cout) << "handle(" << id << "): " << record << '\n';
+    co_return record.size();
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool compute(2);
+        mp_coro::blocking_pool blocking(4, 200ms);
+        const auto [a, b, c, d, e, f] = mp_coro::sync_await(
+            when_all(handle(compute, blocking, 1), handle(compute, blocking, 2),
+                     handle(compute, blocking, 3), handle(compute, blocking, 4),
+                     handle(compute, blocking, 5), handle(compute, blocking, 6)));
+        std::cout << "total size " << a + b + c + d + e + f << ", blocking threads "
+                  << blocking.thread_count() << " (max 4)\n";
+        std::this_thread::sleep_for(500ms);
+        std::cout << "blocking threads after the idle timeout " << blocking.thread_count() << '\n';
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,73 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/bulk.h>
+#include <mp-coro/strand.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+std::uint64_t collatz_steps(std::uint64_t n) {
+    std::uint64_t steps = 0;
+    for (; n != 1; ++steps)
+        n = n % 2 ? 3 * n + 1 : n / 2;
+    return steps;
+}
+
+mp_coro::task<> run(mp_coro::thread_pool &pool) {
+    // 10'000 small jobs enqueued in a single batch, results in the order of the indices
+    const std::vector<std::uint64_t> steps =
+        co_await mp_coro::bulk_schedule(pool, 10'000, [](std::size_t i) {
+            return collatz_steps(i + 1);
+        });
+    const auto longest = std::ranges::max_element(steps);
+    std::cout << "longest Collatz sequence below 10'000 starts at " << longest - steps.begin() + 1
+              << " (" << *longest << " steps)\n";
+
+    // a range of heterogeneous work wrapped in `std::function`
+    std::vector<std::function<std::uint64_t()>> jobs;
+    for (std::uint64_t n : {27U, 97U, 871U, 6171U})
+        jobs.emplace_back([n] { return collatz_steps(n); });
+    for (std::uint64_t s : co_await mp_coro::async_bulk(pool, jobs))
+        std::cout << s << ' ';
+    std::cout << '\n';
+
+    // a non-bulk scheduler is used through `schedule()`
+    mp_coro::strand serial(pool);
+    std::uint64_t total = 0;
+    co_await mp_coro::bulk_schedule(serial, 100, [&](std::size_t i) { total += i; });
+    std::cout << "sum computed on a strand: " << total << '\n';
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool pool;
+        mp_coro::sync_await(run(pool));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,70 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/chunked_file_reader.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+struct stats {
+    std::uint64_t bytes = 0;
+    std::uint64_t lines = 0;
+    std::uint64_t chunks = 0;
+};
+
+// Memory use stays at (read_ahead + 1) chunks whatever the size of the file.
+mp_coro::task<stats> scan(const std::filesystem::path &path, std::size_t chunk_size,
+                          std::size_t read_ahead) {
+    mp_coro::chunked_file_reader reader(path, chunk_size, read_ahead);
+    stats s;
+    // the next chunks are read while this one is processed
+    while (auto chunk = co_await reader.next()) {
+        s.bytes += chunk.size();
+        s.lines += static_cast<std::uint64_t>(std::ranges::count(chunk.text(), '\n'));
+        ++s.chunks;
+    }
+    co_return s;
+}
+
+int main() {
+    try {
+        const auto path = std::filesystem::temp_directory_path() / "mp_coro_chunked_reader.txt";
+        {
+            std::ofstream out(path);
+            for (int i = 0; i < 100'000; ++i)
+                out << "line " << i << '\n';
+        }
+        std::cout << "file of " << std::filesystem::file_size(path) << " bytes\n";
+
+        const stats s = mp_coro::sync_await(scan(path, 64 * 1024, 4));
+        std::cout << s.bytes << " bytes, " << s.lines << " lines read in " << s.chunks
+                  << " chunks of 64 KiB, with at most 5 chunks in memory\n";
+
+        std::filesystem::remove(path);
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
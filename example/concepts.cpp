@@ -22,8 +22,10 @@
 
 #include <mp-coro/async.h>
 #include <mp-coro/concepts.h>
+#include <mp-coro/eager_task.h>
 #include <mp-coro/generator.h>
 #include <mp-coro/task.h>
+#include <mp-coro/value_task.h>
 
 using namespace mp_coro;
 
@@ -81,11 +83,45 @@ static_assert(awaitable_of<task<void> &, void>);
 static_assert(awaitable_of<const task<void> &, void>);
 static_assert(awaitable_of<task<void> &&, void>);
 
+// eager_task<int>
+static_assert(awaitable_of<eager_task<int>, int &&>);
+static_assert(awaitable_of<eager_task<int> &, const int &>);
+static_assert(awaitable_of<eager_task<int> &&, int &&>);
+
+// eager_task<void>
+static_assert(awaitable_of<eager_task<void>, void>);
+static_assert(awaitable_of<eager_task<void> &, void>);
+
+// value_task<int>
+static_assert(awaitable_of<value_task<int>, int &&>);
+static_assert(awaitable_of<value_task<int> &, const int &>);
+static_assert(awaitable_of<const value_task<int> &, const int &>);
+static_assert(awaitable_of<value_task<int> &&, int &&>);
+
+// value_task<int&>
+static_assert(awaitable_of<value_task<int &>, int &>);
+static_assert(awaitable_of<value_task<int &> &, int &>);
+static_assert(awaitable_of<const value_task<int &> &, int &>);
+static_assert(awaitable_of<value_task<int &> &&, int &>);
+
+// value_task<void>
+static_assert(awaitable_of<value_task<void>, void>);
+static_assert(awaitable_of<value_task<void> &, void>);
+static_assert(awaitable_of<const value_task<void> &, void>);
+static_assert(awaitable_of<value_task<void> &&, void>);
+
 // generator<int>
 static_assert(!awaitable<generator<int>>);
 static_assert(std::input_iterator<generator<int>::iterator>);
 static_assert(std::ranges::input_range<generator<int>>);
 static_assert(std::ranges::viewable_range<generator<int>>);
 static_assert(std::ranges::view<generator<int>>);
+static_assert(std::same_as<std::iter_reference_t<generator<int>::iterator>, const int &>);
+
+// generator<int, yield_storage::value>
+static_assert(std::ranges::input_range<generator<int, yield_storage::value>>);
+static_assert(std::ranges::view<generator<int, yield_storage::value>>);
+static_assert(
+    std::same_as<std::iter_reference_t<generator<int, yield_storage::value>::iterator>, int &>);
 
 int main() {}
@@ -0,0 +1,103 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/direct_file.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/when_all.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+constexpr std::size_t block_size = 1 << 20;
+constexpr std::size_t blocks = 16;
+constexpr std::uint64_t file_size = blocks * block_size - 100; // not a multiple of a block
+
+std::byte pattern(std::uint64_t offset) { return static_cast<std::byte>(offset * 31 % 251); }
+
+mp_coro::task<> write_block(mp_coro::direct_file &file, std::uint64_t offset,
+                            std::span<std::byte> buffer) {
+    for (std::size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = pattern(offset + i);
+    co_await file.write(offset, buffer);
+}
+
+// writes the blocks 4 at a time, in parallel
+mp_coro::task<> write_file(const std::filesystem::path &path) {
+    mp_coro::direct_file file(path, mp_coro::file_access::write_only);
+    auto buffers = file.make_buffer_pool(4, block_size);
+    std::vector<std::byte *> batch;
+    for (std::size_t i = 0; i < buffers.count(); ++i)
+        batch.push_back(buffers.try_acquire());
+    for (std::size_t block = 0; block < blocks; block += batch.size()) {
+        std::vector<mp_coro::task<>> writes;
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            writes.push_back(write_block(file, (block + i) * block_size,
+                                         std::span(batch[i], buffers.buffer_size())));
+        co_await when_all(writes);
+    }
+    for (std::byte *buffer : batch)
+        buffers.release(buffer);
+    file.truncate(file_size); // trim the padding of the last block
+}
+
+// a scan that does not pollute the page cache
+mp_coro::task<std::uint64_t> verify_file(const std::filesystem::path &path) {
+    mp_coro::direct_file file(path);
+    auto buffers = file.make_buffer_pool(1, block_size);
+    std::byte *buffer = buffers.try_acquire();
+    std::uint64_t verified = 0;
+    while (true) {
+        const std::size_t n = co_await file.read(verified, std::span(buffer, block_size));
+        for (std::size_t i = 0; i < n; ++i)
+            if (buffer[i] != pattern(verified + i))
+                throw std::runtime_error("data mismatch");
+        verified += n;
+        if (n < block_size)
+            break;
+    }
+    buffers.release(buffer);
+    co_return verified;
+}
+
+int main() {
+    const auto path = std::filesystem::current_path() / "mp_coro_direct_file.bin";
+    try {
+        std::cout << "alignment of direct I/O: "
+                  << mp_coro::direct_file(path, mp_coro::file_access::write_only).alignment()
+                  << " bytes\n";
+        mp_coro::sync_await(write_file(path));
+        std::cout << "verified " << mp_coro::sync_await(verify_file(path)) << " of " << file_size
+                  << " bytes\n";
+    } catch (const std::system_error &ex) {
+        std::cout << "Direct I/O failed (not supported by the file system?): " << ex.what()
+                  << '\n';
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,70 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/eager_task.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <chrono>
+#include <iostream>
+#include <syncstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+template <template <typename> typename Task>
+Task<int> slow_square(mp_coro::thread_pool &pool, int i) {
+    co_await pool.schedule();
+    std::this_thread::sleep_for(200ms);
+    co_return i * i;
+}
+
+template <template <typename> typename Task>
+mp_coro::task<int> sum_of_squares(mp_coro::thread_pool &pool) {
+    auto a = slow_square<Task>(pool, 1);
+    auto b = slow_square<Task>(pool, 2);
+    auto c = slow_square<Task>(pool, 3);
+    co_return co_await a + co_await b + co_await c;
+}
+
+template <template <typename> typename Task>
+void measure(const char *name, mp_coro::thread_pool &pool) {
+    const auto start = std::chrono::steady_clock::now();
+    const int result = mp_coro::sync_await(sum_of_squares<Task>(pool));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << result << " in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+              << " ms\n";
+}
+
+template <typename T>
+using lazy_task = mp_coro::task<T>;
+
+int main() {
+    try {
+        mp_coro::thread_pool pool(3);
+        measure<lazy_task>("task (lazy)", pool);           // ~600 ms: awaited one by one
+        measure<mp_coro::eager_task>("eager_task", pool); // ~200 ms: all started up front
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
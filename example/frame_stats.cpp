@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This example is compiled with `MP_CORO_FRAME_STATS=1` (see CMakeLists.txt)
+
+#include <mp-coro/frame_stats.h>
+#include <mp-coro/generator.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <array>
+#include <iostream>
+#include <numeric>
+
+mp_coro::task<int> small() { co_return 42; }
+
+mp_coro::task<int> large() {
+    std::array<int, 256> buffer {}; // lives across the suspension point below
+    std::iota(buffer.begin(), buffer.end(), co_await small());
+    co_return std::accumulate(buffer.begin(), buffer.end(), 0);
+}
+
+mp_coro::generator<int> counter(int n) {
+    for (int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+int main() {
+    try {
+        std::cout << "large(): " << mp_coro::sync_await(large()) << '\n';
+        for (int i : counter(3))
+            std::cout << i << ' ';
+        std::cout << "\n\n";
+
+        mp_coro::frame_stats::instance().report(std::cout);
+
+        std::cout << "\nframe of small(): " << mp_coro::require_frame_budget<128>(small)
+                  << " bytes\n";
+        std::cout << "frame of large(): " << mp_coro::require_frame_budget<128>(large)
+                  << " bytes\n";
+    } catch (const mp_coro::frame_budget_exceeded &ex) {
+        std::cout << "Frame budget exceeded: " << ex.what() << '\n';
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -21,10 +21,12 @@
 // SOFTWARE.
 
 #include <mp-coro/generator.h>
+#include <mp-coro/generator_adaptors.h>
 #include <mp-coro/type_traits.h>
 #include <cstdint>
 #include <iostream>
 #include <ranges>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -75,6 +77,19 @@ mp_coro::generator<std::tuple<std::ranges::range_reference_t<Rs>...>> zip(Rs &&.
     return zip_impl<Rs...>(std::index_sequence_for<Rs...> {}, std::forward<Rs>(ranges)...);
 }
 
+// every batch is moved into the promise, and then out of it by the consumer
+mp_coro::generator<std::vector<std::string>, mp_coro::yield_storage::value> batches(int count,
+                                                                                   int size) {
+    std::vector<std::string> batch;
+    for (int i = 0; i < count; ++i) {
+        batch.push_back("row " + std::to_string(i));
+        if (std::ssize(batch) == size)
+            co_yield std::exchange(batch, {});
+    }
+    if (!batch.empty())
+        co_yield std::move(batch);
+}
+
 mp_coro::generator<int> broken() {
     co_yield 1;
     throw std::runtime_error("Some error\n");
@@ -132,6 +147,23 @@ int main() {
             std::cout << "[" << v1 << ", " << v2 << "] ";
         std::cout << '\n';
 
+        // stages fused into a single coroutine
+        for (const auto &chunk : iota(1) | mp_coro::fused::filter([](auto i) { return i % 3 == 0; })
+                                     | mp_coro::fused::map([](auto i) { return i * i; })
+                                     | mp_coro::fused::chunk(3) | mp_coro::fused::take(3)) {
+            for (auto v : chunk)
+                std::cout << v << ' ';
+            std::cout << "| ";
+        }
+        std::cout << '\n';
+
+        std::vector<std::vector<std::string>> taken;
+        for (auto &batch : batches(7, 3))
+            taken.push_back(std::move(batch));
+        for (const auto &batch : taken)
+            std::cout << batch.front() << ".." << batch.back() << " | ";
+        std::cout << '\n';
+
         for (auto v : broken())
             std::cout << v << ' ';
         std::cout << '\n';
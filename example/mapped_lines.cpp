@@ -0,0 +1,59 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/generator_adaptors.h>
+#include <mp-coro/mapped_file.h>
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+
+// Usage: mapped_lines [path]
+int main(int argc, char *argv[]) {
+    try {
+        const char *path = argc > 1 ? argv[1] : "/etc/passwd";
+
+        // the lines are views into the mapped file, nothing is copied
+        std::size_t count = 0, longest = 0;
+        for (std::string_view line : mp_coro::mapped_lines(path)) {
+            ++count;
+            longest = std::max(longest, line.size());
+        }
+        std::cout << path << ": " << count << " lines, the longest has " << longest
+                  << " characters\n";
+
+        // the first field of the first 5 lines
+        for (std::string_view name :
+             mp_coro::mapped_lines(path) | mp_coro::fused::take(5) |
+                 mp_coro::fused::map([](std::string_view line) {
+                     return line.substr(0, line.find(':'));
+                 }))
+            std::cout << name << ' ';
+        std::cout << '\n';
+
+        for (std::string_view line : mp_coro::lines("first\nsecond\r\n\nlast"))
+            std::cout << '[' << line.substr(0, line.find('\r')) << "] ";
+        std::cout << '\n';
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
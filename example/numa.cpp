@@ -0,0 +1,57 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/numa.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <iostream>
+#include <syncstream>
+
+// With MP_CORO_NUMA_FRAMES, the frame of `leaf()` comes from the pool of the
+// node of the worker it is started on
+mp_coro::task<std::size_t> leaf() { co_return mp_coro::this_numa_node(); }
+
+mp_coro::task<> worker(mp_coro::thread_pool &pool, int i) {
+    co_await pool.schedule();
+    const std::size_t node = co_await leaf();
+    std::osyncstream(std::cout) << "task " << i << " ran on node " << node << '\n';
+}
+
+int main() {
+    try {
+        const auto topology = mp_coro::numa_topology::discover();
+        for (const auto &node : topology.nodes()) {
+            std::cout << "node " << node.id << ": CPUs";
+            for (const unsigned cpu : node.cpus)
+                std::cout << ' ' << cpu;
+            std::cout << '\n';
+        }
+
+        // 2 workers per node, each restricted to the CPUs of its node
+        mp_coro::thread_pool pool(topology.place_workers(2 * topology.nodes().size()));
+        mp_coro::sync_await(when_all(worker(pool, 1), worker(pool, 2), worker(pool, 3)));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
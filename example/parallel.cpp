@@ -0,0 +1,66 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/parallel.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+mp_coro::task<> run(mp_coro::thread_pool &pool) {
+    std::vector<double> v(1'000'000);
+    std::iota(v.begin(), v.end(), 1.0);
+
+    const double norm = std::sqrt(co_await mp_coro::parallel_transform_reduce(
+        pool, v, 0.0, std::plus<>(), [](double x) { return x * x; }));
+    std::cout << "norm: " << norm << '\n';
+
+    co_await mp_coro::parallel_for_each(pool, v, [=](double &x) { x /= norm; });
+
+    std::vector<float> halves(v.size());
+    co_await mp_coro::parallel_transform(
+        pool, v, halves.begin(), [](double x) { return static_cast<float>(x / 2); },
+        10'000); // explicit grain size
+    std::cout << "last: " << v.back() << ", its half: " << halves.back() << '\n';
+
+    try {
+        co_await mp_coro::parallel_for_each(pool, std::vector<int>(100, 0), [](int) {
+            throw std::runtime_error("failed");
+        });
+    } catch (const std::exception &ex) {
+        std::cout << "caught: " << ex.what() << '\n';
+    }
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool pool;
+        mp_coro::sync_await(run(pool));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
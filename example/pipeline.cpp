@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/generator.h>
+#include <mp-coro/pipeline.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace std::chrono_literals;
+using namespace mp_coro;
+
+generator<int> read_ids(int count) {
+    for (int i = 1; i <= count; ++i)
+        co_yield i;
+}
+
+// slow and uneven, so the results complete out of order
+std::string fetch(int id) {
+    std::this_thread::sleep_for(std::chrono::milliseconds((id * 37) % 20));
+    return "record " + std::to_string(id);
+}
+
+int main() {
+    try {
+        thread_pool pool(4);
+
+        // the records are printed in the order of the ids, 4 fetches at a time
+        sync_await(pipeline::source(read_ids(12))                    //
+                   | pipeline::parallel_map(pool, fetch, 4)          //
+                   | pipeline::filter([](const std::string &record) { //
+                         return record.back() != '3';
+                     })                                                            //
+                   | pipeline::map([](std::string record) { return record + "!"; }) //
+                   | pipeline::sink([](std::string record) { std::cout << record << '\n'; }));
+
+        // a failure in a stage stops the pipeline
+        try {
+            sync_await(pipeline::source(read_ids(1'000'000))       //
+                       | pipeline::parallel_map(pool,               //
+                                                [](int id) {
+                                                    if (id == 100)
+                                                        throw std::runtime_error("bad id");
+                                                    return id;
+                                                },
+                                                8) //
+                       | pipeline::sink([](int) {}));
+        } catch (const std::exception &ex) {
+            std::cout << "caught: " << ex.what() << '\n';
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/async.h>
+#include <mp-coro/schedule_on.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <iostream>
+#include <numeric>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+struct tid_t {
+    friend std::ostream &operator<<(std::ostream &os, tid_t) {
+        return os << "(tid=" << std::this_thread::get_id() << ')';
+    }
+};
+inline constexpr tid_t tid;
+
+mp_coro::task<long> crunch(const std::vector<int> &data) {
+    std::osyncstream(std::cout) << tid << " crunch(): computing\n";
+    co_return std::accumulate(data.begin(), data.end(), 0L);
+}
+
+mp_coro::task<> handle(mp_coro::thread_pool &io, mp_coro::thread_pool &compute) {
+    using namespace mp_coro;
+    co_await io.schedule();
+    std::osyncstream(std::cout) << tid << " handle(): reading on io\n";
+    const std::vector<int> data(1000, 1);
+
+    // no extra frame: `crunch()` itself is scheduled on the compute pool
+    const long sum = co_await schedule_on(compute, crunch(data));
+    std::osyncstream(std::cout) << tid << " handle(): got " << sum << " on compute\n";
+
+    co_await resume_on(io);
+    std::osyncstream(std::cout) << tid << " handle(): writing on io\n";
+
+    // awaitables that do not use symmetric transfer are wrapped in a task
+    const int answer = co_await schedule_on(compute, async([] { return 42; }));
+    std::osyncstream(std::cout) << tid << " handle(): got " << answer << '\n';
+
+    const long again = co_await (crunch(data) | resume_on(io));
+    std::osyncstream(std::cout) << tid << " handle(): got " << again << " on io\n";
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool io(1);
+        mp_coro::thread_pool compute(2);
+        mp_coro::sync_await(handle(io, compute));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,85 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sharded_runtime.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/when_all.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// Every shard owns a part of the keys: the maps are never accessed concurrently
+class kv_store {
+  public:
+    explicit kv_store(mp_coro::sharded_runtime &rt) : rt_(rt), maps_(rt.shard_count()) {}
+
+    mp_coro::task<> put(std::string key, std::string value) {
+        const std::size_t owner = owner_of(key);
+        co_await rt_.submit_to(owner, [&] { maps_[owner][key] = value; });
+    }
+
+    mp_coro::task<std::optional<std::string>> get(std::string key) {
+        const std::size_t owner = owner_of(key);
+        co_return co_await rt_.submit_to(owner, [&]() -> std::optional<std::string> {
+            const auto &map = maps_[owner];
+            if (const auto it = map.find(key); it != map.end())
+                return it->second;
+            return std::nullopt;
+        });
+    }
+
+  private:
+    std::size_t owner_of(const std::string &key) const {
+        return std::hash<std::string> {}(key) % rt_.shard_count();
+    }
+
+    mp_coro::sharded_runtime &rt_;
+    std::vector<std::unordered_map<std::string, std::string>> maps_;
+};
+
+mp_coro::task<> client(mp_coro::sharded_runtime &rt, kv_store &store) {
+    co_await rt.schedule(0);
+    co_await store.put("apple", "red");
+    co_await store.put("banana", "yellow");
+    co_await rt.sleep_for(10ms); // a timer of shard 0
+    const auto apple = co_await store.get("apple");
+    const auto cherry = co_await store.get("cherry");
+    std::cout << "client() on shard " << rt.this_shard() << ": apple is "
+              << apple.value_or("unknown") << ", cherry is " << cherry.value_or("unknown") << '\n';
+}
+
+int main() {
+    try {
+        mp_coro::sharded_runtime rt(4);
+        kv_store store(rt);
+        mp_coro::sync_await(client(rt, store));
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,80 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/strand.h>
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+// Actor-style component: its state is only ever touched on its strand
+class account {
+  public:
+    explicit account(mp_coro::thread_pool &pool) : strand_(pool) {}
+
+    mp_coro::task<> deposit(long amount) {
+        co_await strand_.schedule();
+        balance_ += amount; // no mutex needed
+    }
+
+    mp_coro::task<long> balance() {
+        co_await strand_.schedule();
+        co_return balance_;
+    }
+
+  private:
+    mp_coro::strand<mp_coro::thread_pool> strand_;
+    long balance_ = 0;
+};
+
+mp_coro::task<> client(mp_coro::thread_pool &pool, account &acc, int deposits) {
+    for (int i = 0; i < deposits; ++i) {
+        co_await pool.schedule(); // leave the strand and compete for it again
+        co_await acc.deposit(1);
+    }
+}
+
+mp_coro::task<long> example(mp_coro::thread_pool &pool, account &acc) {
+    std::vector<mp_coro::task<>> clients;
+    for (int i = 0; i < 8; ++i)
+        clients.push_back(client(pool, acc, 10'000));
+    co_await mp_coro::when_all(std::move(clients));
+    co_return co_await acc.balance();
+}
+
+int main() {
+    try {
+        std::optional<account> acc;
+        long balance = 0;
+        {
+            mp_coro::thread_pool pool(4);
+            acc.emplace(pool);
+            balance = mp_coro::sync_await(example(pool, *acc));
+        } // joins the workers, so nothing runs on the strand anymore
+        std::cout << "balance: " << balance << " (expected 80000)\n";
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,97 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/task_graph.h>
+#include <mp-coro/thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// An ETL job with a diamond: both `sum` and `max` depend on `load`, and
+// `report` depends on both of them.
+int main() {
+    try {
+        mp_coro::thread_pool pool(4);
+        std::vector<int> data;
+        std::atomic<long> sum = 0;
+        std::atomic<int> max = 0;
+        int round = 0;
+
+        const auto log = [](const char *msg) {
+            std::osyncstream(std::cout)
+                << "  " << msg << " on thread " << std::this_thread::get_id() << '\n';
+        };
+
+        mp_coro::task_graph graph;
+        const auto load = graph.add([&]() -> mp_coro::task<> {
+            co_await pool.schedule(); // e.g. awaiting an I/O operation
+            data.resize(1000);
+            std::iota(data.begin(), data.end(), round * 1000);
+            log("load");
+        });
+        const auto sum_node = graph.add(
+            [&] {
+                sum = std::accumulate(data.begin(), data.end(), 0L);
+                std::this_thread::sleep_for(10ms);
+                log("sum");
+            },
+            {load});
+        const auto max_node = graph.add(
+            [&] {
+                max = *std::max_element(data.begin(), data.end());
+                std::this_thread::sleep_for(10ms);
+                log("max");
+            },
+            {load});
+        graph.add([&] { std::cout << "  report: sum " << sum << ", max " << max << '\n'; },
+                  {sum_node, max_node});
+
+        // the graph is reused without rebuilding it
+        for (round = 0; round < 2; ++round) {
+            std::cout << "round " << round << '\n';
+            mp_coro::sync_await(graph.run(pool));
+        }
+
+        // a failing node skips the nodes depending on it
+        mp_coro::task_graph failing;
+        const auto bad = failing.add([]() -> int { throw std::runtime_error("load failed"); });
+        failing.add([] { std::cout << "never printed\n"; }, {bad});
+        failing.add([] { std::cout << "independent node still runs\n"; });
+        try {
+            mp_coro::sync_await(failing.run(pool));
+        } catch (const std::exception &ex) {
+            std::cout << "caught: " << ex.what() << '\n';
+        }
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,58 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <iostream>
+#include <syncstream>
+#include <thread>
+
+struct tid_t {
+    friend std::ostream &operator<<(std::ostream &os, tid_t) {
+        return os << "(tid=" << std::this_thread::get_id() << ')';
+    }
+};
+inline constexpr tid_t tid;
+
+mp_coro::task<int> square(mp_coro::thread_pool &pool, int i) {
+    std::osyncstream(std::cout) << tid << " square(" << i << "): before schedule\n";
+    co_await pool.schedule();
+    std::osyncstream(std::cout) << tid << " square(" << i << "): on the pool\n";
+    co_return i * i;
+}
+
+mp_coro::task<int> sum_of_squares(mp_coro::thread_pool &pool) {
+    const auto [a, b, c] = co_await when_all(square(pool, 1), square(pool, 2), square(pool, 3));
+    co_return a + b + c;
+}
+
+int main() {
+    try {
+        mp_coro::thread_pool pool(2);
+        const int result = sync_await(sum_of_squares(pool));
+        std::cout << tid << " main(): result " << result << '\n';
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,69 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/value_task.h>
+#include <iostream>
+#include <map>
+#include <string>
+
+std::map<int, std::string> cache = {{1, "one"}, {2, "two"}};
+
+mp_coro::task<std::string> fetch(int key) {
+    std::cout << "fetch(" << key << "): cache miss\n";
+    co_return "value #" + std::to_string(key);
+}
+
+// Not a coroutine: no frame is allocated on a cache hit
+mp_coro::value_task<std::string> lookup(int key) {
+    if (auto it = cache.find(key); it != cache.end())
+        return it->second;
+    return fetch(key);
+}
+
+mp_coro::value_task<> flush(bool dirty) {
+    if (!dirty)
+        return {};
+    return []() -> mp_coro::task<> {
+        std::cout << "flush(): flushing\n";
+        co_return;
+    }();
+}
+
+mp_coro::task<> example() {
+    for (int key : {1, 2, 3}) {
+        auto result = lookup(key);
+        std::cout << "lookup(" << key << ")" << (result.is_ready() ? " (ready)" : "") << ": "
+                  << co_await std::move(result) << '\n';
+    }
+    co_await flush(false);
+    co_await flush(true);
+}
+
+int main() {
+    try {
+        mp_coro::sync_await(example());
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/thread_pool.h>
+#include <mp-coro/when_all.h>
+#include <mp-coro/yield.h>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+// completes synchronously: awaiting it is a pair of symmetric transfers
+mp_coro::task<std::uint64_t> step(std::uint64_t i) { co_return i * i % 7; }
+
+mp_coro::task<std::uint64_t> long_chain(mp_coro::thread_pool &pool, std::atomic<bool> &done) {
+    co_await pool.schedule();
+    std::uint64_t sum = 0;
+    for (std::uint64_t i = 0; i < 10'000; ++i)
+        sum += co_await step(i);
+    done = true;
+    co_return sum;
+}
+
+// counts how many times it got the worker while the chain was running
+mp_coro::task<int> ticker(mp_coro::thread_pool &pool, const std::atomic<bool> &done) {
+    co_await pool.schedule();
+    int ticks = 0;
+    while (!done) {
+        ++ticks;
+        co_await mp_coro::yield();
+    }
+    co_return ticks;
+}
+
+void run(std::size_t resume_budget) {
+    mp_coro::thread_pool pool(1, 16, resume_budget);
+    std::atomic<bool> done = false;
+    const auto [sum, ticks] =
+        mp_coro::sync_await(when_all(long_chain(pool, done), ticker(pool, done)));
+    std::cout << "resume budget " << resume_budget << ": sum " << sum << ", the ticker ran "
+              << ticks << " times during the chain\n";
+}
+
+int main() {
+    try {
+        run(0); // no preemption: the chain holds the only worker until it is done
+        run(64);
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+}
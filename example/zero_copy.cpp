@@ -0,0 +1,105 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <mp-coro/sync_await.h>
+#include <mp-coro/task.h>
+#include <mp-coro/when_all.h>
+#include <mp-coro/zero_copy.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+int open_file(const std::filesystem::path &path, int flags) {
+    const int fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::system_category(), "open " + path.string());
+    return fd;
+}
+
+// the data never leaves the kernel
+mp_coro::task<std::uint64_t> copy_in_kernel(const std::filesystem::path &from,
+                                       const std::filesystem::path &to) {
+    const int in = open_file(from, O_RDONLY);
+    const int out = open_file(to, O_WRONLY | O_CREAT | O_TRUNC);
+    const auto size = std::filesystem::file_size(from);
+    std::uint64_t offset = 0;
+    while (offset < size) {
+        const std::size_t n = co_await mp_coro::async_copy_file_range(
+            in, offset, out, offset, static_cast<std::size_t>(size - offset));
+        if (n == 0)
+            break; // truncated meanwhile
+        offset += n;
+    }
+    ::close(in);
+    ::close(out);
+    co_return offset;
+}
+
+// e.g. a socket
+mp_coro::task<> send_file(const std::filesystem::path &path, int out) {
+    const int in = open_file(path, O_RDONLY);
+    const auto size = std::filesystem::file_size(path);
+    for (std::uint64_t offset = 0; offset < size;)
+        offset += co_await mp_coro::async_sendfile(out, in, offset,
+                                                   static_cast<std::size_t>(size - offset));
+    ::close(in);
+    ::close(out); // end of stream for the receiver
+}
+
+mp_coro::task<std::string> receive(int in) {
+    std::string text;
+    char buffer[64];
+    while (true) {
+        const auto n = co_await mp_coro::async_blocking([&] { return ::read(in, buffer, 64); });
+        if (n <= 0)
+            break;
+        text.append(buffer, static_cast<std::size_t>(n));
+    }
+    ::close(in);
+    co_return text;
+}
+
+int main() {
+    const auto from = std::filesystem::current_path() / "mp_coro_zero_copy.src";
+    const auto to = std::filesystem::current_path() / "mp_coro_zero_copy.dst";
+    try {
+        std::ofstream(from) << "Hello from the page cache!\n";
+        std::cout << "copied " << mp_coro::sync_await(copy_in_kernel(from, to)) << " bytes\n";
+
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) < 0)
+            throw std::system_error(errno, std::system_category(), "pipe2");
+        const auto [sent, text] =
+            mp_coro::sync_await(when_all(send_file(to, fds[1]), receive(fds[0])));
+        std::cout << "received through a pipe: " << text;
+    } catch (const std::exception &ex) {
+        std::cout << "Unhandled exception: " << ex.what() << '\n';
+    }
+    std::filesystem::remove(from);
+    std::filesystem::remove(to);
+}
@@ -0,0 +1,221 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/frame_allocation.h>
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/trace.h>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace mp_coro {
+
+class async_scope;
+
+namespace detail {
+
+/// Eagerly started coroutine owned by an @ref async_scope. It destroys itself
+/// on completion and notifies the scope.
+struct scope_task {
+    struct promise_type : frame_allocation<promise_type> {
+        async_scope &scope;
+
+        /// The first parameter of every coroutine returning a
+        /// @ref scope_task is its @ref async_scope.
+        template <typename... Args>
+        explicit promise_type(async_scope &s, Args &...) noexcept : scope(s) {}
+
+        scope_task get_return_object() noexcept {
+            TRACE_FUNC();
+            return {};
+        }
+        static std::suspend_never initial_suspend() noexcept {
+            TRACE_FUNC();
+            return {};
+        }
+        static void return_void() noexcept { TRACE_FUNC(); }
+        void unhandled_exception() noexcept;
+
+        struct final_awaiter : std::suspend_always {
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> this_coro) noexcept;
+        };
+        static awaiter_of<void> auto final_suspend() noexcept {
+            TRACE_FUNC();
+            return final_awaiter {};
+        }
+    };
+};
+
+template <scheduler S, awaitable A>
+scope_task spawn_on(async_scope &, S &sched, A awaitable) {
+    co_await sched.schedule();
+    co_await std::move(awaitable);
+}
+
+template <awaitable A>
+scope_task spawn_inline(async_scope &, A awaitable) {
+    co_await std::move(awaitable);
+}
+
+} // namespace detail
+
+/// Owner of "fire-and-forget" work: @ref spawn() starts awaitables without
+/// awaiting them, and @ref join() waits for all of them to complete.
+///
+/// Each spawned awaitable is awaited by a coroutine that frees itself on
+/// completion, so spawning costs one coroutine frame (in which the awaitable
+/// is stored) and one atomic increment. Completions are counted in a single
+/// atomic counter that holds one extra reference for @ref join(), similarly
+/// to @ref when_all().
+///
+/// The first exception thrown by the spawned work is rethrown from
+/// @ref join().
+///
+/// @pre    The scope must be joined before it is destroyed.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> serve(thread_pool &pool, async_scope &scope) {
+///     while (auto request = co_await next_request()) {
+///         co_await handle(*request);
+///         scope.spawn(pool, flush_logs()); // don't wait for the flush
+///     }
+///     co_await scope.join();
+/// }
+/// ```
+class async_scope : private detail::noncopyable {
+  public:
+    async_scope() = default;
+    ~async_scope() {
+        assert(count_.load(std::memory_order_relaxed) == 1 && "async_scope destroyed before join");
+    }
+
+    /// Awaits @p awaitable on one of the threads of @p sched without waiting
+    /// for the result.
+    template <scheduler S, awaitable A>
+    requires std::move_constructible<std::remove_cvref_t<A>>
+    void spawn(S &sched, A &&awaitable) {
+        TRACE_FUNC();
+        start_counted([&] { detail::spawn_on(*this, sched, std::forward<A>(awaitable)); });
+    }
+
+    /// Starts awaiting @p awaitable right away on the current thread (until
+    /// its first suspension point) without waiting for the result.
+    template <awaitable A>
+    requires std::move_constructible<std::remove_cvref_t<A>>
+    void spawn(A &&awaitable) {
+        TRACE_FUNC();
+        start_counted([&] { detail::spawn_inline(*this, std::forward<A>(awaitable)); });
+    }
+
+    /// Returns an awaitable that completes when all the spawned work has
+    /// completed. Work spawned by the spawned work is waited for as well. The
+    /// scope can be reused once joined.
+    [[nodiscard]] awaiter_of<void> auto join() noexcept {
+        TRACE_FUNC();
+        struct awaiter {
+            async_scope &scope;
+
+            bool await_ready() const noexcept {
+                TRACE_FUNC();
+                return scope.count_.load(std::memory_order_acquire) == 1;
+            }
+            bool await_suspend(std::coroutine_handle<> handle) noexcept {
+                TRACE_FUNC();
+                scope.continuation_ = handle;
+                return scope.count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+            }
+            void await_resume() const {
+                TRACE_FUNC();
+                scope.count_.store(1, std::memory_order_relaxed);
+                if (scope.has_exception_.exchange(false, std::memory_order_relaxed))
+                    std::rethrow_exception(std::exchange(scope.exception_, nullptr));
+            }
+        };
+        return awaiter {*this};
+    }
+
+  private:
+    friend detail::scope_task::promise_type;
+
+    /// Counts the coroutine started by @p start before it can complete. It is
+    /// not counted if it could not be started (e.g. its frame could not be
+    /// allocated).
+    template <std::invocable Start>
+    void start_counted(Start start) {
+        count_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            start();
+        } catch (...) {
+            notify_completed().resume();
+            throw;
+        }
+    }
+
+    /// Called when a spawned coroutine completes.
+    /// @returns the coroutine awaiting @ref join() if it should be resumed.
+    std::coroutine_handle<> notify_completed() noexcept {
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            return continuation_;
+        return std::noop_coroutine();
+    }
+
+    void set_exception(std::exception_ptr ex) noexcept {
+        if (!has_exception_.exchange(true, std::memory_order_relaxed))
+            exception_ = std::move(ex);
+    }
+
+    std::atomic<std::size_t> count_ = 1; // +1 for the one awaiting join()
+    std::coroutine_handle<> continuation_;
+    std::atomic<bool> has_exception_ = false;
+    std::exception_ptr exception_;
+};
+
+namespace detail {
+
+inline void scope_task::promise_type::unhandled_exception() noexcept {
+    TRACE_FUNC();
+    scope.set_exception(std::current_exception());
+}
+
+inline std::coroutine_handle<>
+scope_task::promise_type::final_awaiter::await_suspend(
+    std::coroutine_handle<promise_type> this_coro) noexcept {
+    TRACE_FUNC();
+    async_scope &scope = this_coro.promise().scope;
+    this_coro.destroy();
+    return scope.notify_completed();
+}
+
+} // namespace detail
+
+} // namespace mp_coro
@@ -0,0 +1,293 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace mp_coro {
+
+/// Append-only write-ahead log with group commit: many coroutines can
+/// `co_await wal.append(record)` concurrently, and each resumes once its
+/// record is durable.
+///
+/// A single writer (a job on a @ref blocking_pool) takes all the records
+/// appended so far as a batch, writes them with one `pwritev()` straight from
+/// the awaiters' buffers, makes them durable with one `fdatasync()`, and
+/// resumes all the waiters of the batch inline, on its thread. Records
+/// appended meanwhile form the next batch, so the cost of a sync is shared by
+/// all the concurrent writers, and the more of them there are, the bigger the
+/// batches get.
+///
+/// Records are written as they are, in the order of the batch. The caller
+/// frames them (e.g. with their length and checksum) to be able to read the
+/// log back. After a failed write or sync, the durability of the log is
+/// unknown, so this and all the following appends fail.
+///
+/// All the appends must complete before the log is destroyed.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> commit(async_wal &wal, const transaction &tx) {
+///     const std::string record = encode(tx);
+///     const std::uint64_t offset = co_await wal.append(record); // durable now
+///     apply(tx);
+/// }
+/// ```
+class async_wal : private detail::noncopyable {
+  public:
+    /// Awaiter returned by @ref append(). Also serves as the node of the
+    /// intrusive queue of the records waiting for the writer.
+    class append_operation {
+      public:
+        append_operation(async_wal &wal, std::span<const std::byte> record) noexcept
+            : wal_(wal), record_(record) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            handle_ = handle;
+            wal_.enqueue(*this);
+        }
+
+        /// Returns the offset of the record in the log.
+        /// @throws std::system_error if the record could not be made durable.
+        std::uint64_t await_resume() const {
+            TRACE_FUNC();
+            if (error_)
+                throw std::system_error(error_, "async_wal");
+            return offset_;
+        }
+
+      private:
+        friend async_wal;
+        async_wal &wal_;
+        std::span<const std::byte> record_;
+        std::coroutine_handle<> handle_;
+        append_operation *next_ = nullptr;
+        std::uint64_t offset_ = 0;
+        std::error_code error_;
+    };
+
+    /// Opens (or creates) the log at @p path. New records are appended after
+    /// its current contents.
+    /// @param  pool  Threads running the writer.
+    /// @throws std::system_error if the file can't be opened.
+    explicit async_wal(const std::filesystem::path &path,
+                       blocking_pool &pool = blocking_pool::global())
+        : pool_(pool), writer_(*this) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+            throw std::system_error(errno, std::system_category(), "open " + path.string());
+        struct ::stat st;
+        if (::fstat(fd_, &st) < 0) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::system_category(), "fstat " + path.string());
+        }
+        end_ = static_cast<std::uint64_t>(st.st_size);
+    }
+
+    ~async_wal() {
+        assert(!writing_ && !head_ && "appends still in progress");
+        ::close(fd_);
+    }
+
+    /// Returns an awaitable that appends @p record to the log, and produces
+    /// its offset once it is durable. @p record must stay valid until then.
+    [[nodiscard]] append_operation append(std::span<const std::byte> record) noexcept {
+        return append_operation {*this, record};
+    }
+    /// @copydoc append(std::span<const std::byte>)
+    [[nodiscard]] append_operation append(std::string_view record) noexcept {
+        return append(std::as_bytes(std::span(record)));
+    }
+
+    /// Number of records made durable so far.
+    [[nodiscard]] std::uint64_t records() const {
+        std::lock_guard lock(mutex_);
+        return records_;
+    }
+
+    /// Number of syncs done so far (one per batch).
+    [[nodiscard]] std::uint64_t syncs() const {
+        std::lock_guard lock(mutex_);
+        return syncs_;
+    }
+
+  private:
+    struct writer_job : blocking_pool::job {
+        explicit writer_job(async_wal &w) noexcept : job(&execute), wal(w) {}
+        async_wal &wal;
+
+        static void execute(blocking_pool::job &j) noexcept {
+            TRACE_FUNC();
+            static_cast<writer_job &>(j).wal.write_batches();
+        }
+    };
+
+    void enqueue(append_operation &op) {
+        std::lock_guard lock(mutex_);
+        if (tail_)
+            tail_->next_ = &op;
+        else
+            head_ = &op;
+        tail_ = &op;
+        if (std::exchange(writing_, true))
+            return; // the writer will pick it up with its next batch
+        // submitted under the lock, so that nothing is queued behind `op` if it fails
+        try {
+            pool_.submit(writer_);
+        } catch (...) {
+            head_ = tail_ = nullptr; // `op` was the only record
+            writing_ = false;
+            throw;
+        }
+    }
+
+    /// Takes all the queued records as the next batch, or stops the writer
+    /// if there are none.
+    append_operation *take_batch() {
+        std::lock_guard lock(mutex_);
+        append_operation *batch = std::exchange(head_, nullptr);
+        tail_ = nullptr;
+        if (!batch)
+            writing_ = false;
+        return batch;
+    }
+
+    void write_batches() {
+        append_operation *batch = take_batch();
+        while (batch) {
+            const std::size_t count = commit(batch);
+            // the next batch is taken before the waiters are resumed: the last
+            // one may destroy the log
+            append_operation *next = take_batch();
+            {
+                std::lock_guard lock(mutex_);
+                records_ += count;
+                syncs_ += count > 0 ? 1 : 0;
+            }
+            while (batch) {
+                append_operation &op = *std::exchange(batch, batch->next_);
+                op.handle_.resume();
+            }
+            batch = next;
+        }
+    }
+
+    /// Writes the records of @p batch with `pwritev()` and syncs them.
+    /// Returns the number of records made durable.
+    std::size_t commit(append_operation *batch) {
+        iovecs_.clear();
+        std::uint64_t end = end_;
+        for (append_operation *op = batch; op; op = op->next_) {
+            op->offset_ = end;
+            end += op->record_.size();
+            iovecs_.push_back({const_cast<std::byte *>(op->record_.data()), op->record_.size()});
+        }
+        std::error_code error = failure_;
+        if (!error)
+            error = write_all();
+        if (!error && ::fdatasync(fd_) < 0)
+            error = std::error_code(errno, std::system_category());
+        if (error) {
+            failure_ = error; // the state of the log is unknown from now on
+            for (append_operation *op = batch; op; op = op->next_)
+                op->error_ = error;
+            return 0;
+        }
+        end_ = end;
+        return iovecs_.size();
+    }
+
+    /// Writes all of `iovecs_` at `end_`, at most `IOV_MAX` of them per call.
+    std::error_code write_all() {
+        std::span<::iovec> pending(iovecs_);
+        std::uint64_t offset = end_;
+        while (!pending.empty()) {
+            const int count = static_cast<int>(std::min<std::size_t>(pending.size(), IOV_MAX));
+            const auto n = ::pwritev(fd_, pending.data(), count, static_cast<::off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return std::error_code(errno, std::system_category());
+            }
+            offset += static_cast<std::uint64_t>(n);
+            // skip what was written (a partial write may end inside a record)
+            auto left = static_cast<std::size_t>(n);
+            while (!pending.empty() && left >= pending.front().iov_len) {
+                left -= pending.front().iov_len;
+                pending = pending.subspan(1);
+            }
+            if (left > 0) {
+                ::iovec &partial = pending.front();
+                partial.iov_base = static_cast<std::byte *>(partial.iov_base) + left;
+                partial.iov_len -= left;
+            }
+        }
+        return {};
+    }
+
+    blocking_pool &pool_;
+    writer_job writer_;
+    int fd_ = -1;
+    mutable std::mutex mutex_;
+    append_operation *head_ = nullptr; // records waiting for the next batch
+    append_operation *tail_ = nullptr;
+    bool writing_ = false;
+    std::uint64_t records_ = 0;
+    std::uint64_t syncs_ = 0;
+    // used by the writer only
+    std::uint64_t end_ = 0; // size of the log
+    std::vector<::iovec> iovecs_;
+    std::error_code failure_;
+};
+
+} // namespace mp_coro
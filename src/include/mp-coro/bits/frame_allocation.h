@@ -0,0 +1,91 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#if defined(MP_CORO_FRAME_STATS) && MP_CORO_FRAME_STATS
+#include <mp-coro/frame_stats.h>
+#include <source_location>
+#endif
+
+#if defined(MP_CORO_NUMA_FRAMES) && MP_CORO_NUMA_FRAMES
+#include <mp-coro/numa.h>
+#endif
+
+namespace mp_coro::detail {
+
+/// Allocates a coroutine frame: from the pool of the NUMA node of the current
+/// thread with `MP_CORO_NUMA_FRAMES`, with the global `operator new`
+/// otherwise.
+[[nodiscard]] inline void *allocate_frame(std::size_t size) {
+#if defined(MP_CORO_NUMA_FRAMES) && MP_CORO_NUMA_FRAMES
+    return numa_frame_pool::instance().allocate(size);
+#else
+    return ::operator new(size);
+#endif
+}
+
+inline void deallocate_frame(void *ptr, std::size_t size) noexcept {
+#if defined(MP_CORO_NUMA_FRAMES) && MP_CORO_NUMA_FRAMES
+    numa_frame_pool::instance().deallocate(ptr, size);
+#else
+    ::operator delete(ptr, size);
+#endif
+}
+
+/// Base class of the promise types that provides the coroutine frame
+/// allocation functions.
+///
+/// Without `MP_CORO_FRAME_STATS` and `MP_CORO_NUMA_FRAMES` it is empty and the
+/// frames are allocated with the global `operator new`.
+///
+/// With `MP_CORO_FRAME_STATS`, the size of every frame is recorded in
+/// @ref mp_coro::frame_stats together with the coroutine function (the
+/// default argument of type `std::source_location` is evaluated at the
+/// compiler generated call site, i.e. in the coroutine function).
+///
+/// With `MP_CORO_NUMA_FRAMES`, the frames of the coroutines started on a
+/// thread bound to a NUMA node (e.g. a @ref mp_coro::thread_pool worker with
+/// a @ref mp_coro::worker_affinity) come from a pool local to that node.
+template <typename Promise>
+struct frame_allocation {
+#if defined(MP_CORO_FRAME_STATS) && MP_CORO_FRAME_STATS
+    static void *operator new(std::size_t size,
+                              std::source_location loc = std::source_location::current()) {
+        frame_stats::instance().record(size, loc, type_name<Promise>());
+        return allocate_frame(size);
+    }
+#elif defined(MP_CORO_NUMA_FRAMES) && MP_CORO_NUMA_FRAMES
+    static void *operator new(std::size_t size) { return allocate_frame(size); }
+#endif
+#if (defined(MP_CORO_FRAME_STATS) && MP_CORO_FRAME_STATS) ||                                     \
+    (defined(MP_CORO_NUMA_FRAMES) && MP_CORO_NUMA_FRAMES)
+    static void operator delete(void *ptr, std::size_t size) noexcept {
+        deallocate_frame(ptr, size);
+    }
+#endif
+};
+
+} // namespace mp_coro::detail
@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+
+namespace mp_coro::detail {
+
+/// Node of the intrusive queue a coroutine is yielded to by a
+/// @ref resumption_budget.
+struct work_item {
+    std::coroutine_handle<> handle;
+    work_item *next = nullptr;
+};
+
+/// Cooperative preemption of the coroutines running on a worker thread.
+///
+/// A scheduler installs a budget on its worker thread for every coroutine it
+/// resumes. Each symmetric transfer between tasks consumes one unit of it, and
+/// once it is exhausted the coroutine that would have been resumed next is
+/// handed to @ref yield() (i.e. moved to the back of the queue of the worker)
+/// instead, so a chain of synchronously completing `co_await`s can't keep the
+/// other coroutines waiting indefinitely.
+class resumption_budget : private noncopyable {
+  public:
+    /// Installs a budget on the current thread for the lifetime of the scope
+    /// (`nullptr` disables the preemption, e.g. for executors that rely on
+    /// the coroutines they resume staying on the current thread).
+    class scope : private noncopyable {
+      public:
+        explicit scope(resumption_budget *budget) noexcept
+            : previous_(std::exchange(current_, budget)) {}
+        ~scope() { current_ = previous_; }
+
+      private:
+        resumption_budget *previous_;
+    };
+
+    /// Budget of the current thread, if any.
+    [[nodiscard]] static resumption_budget *current() noexcept { return current_; }
+
+    /// Consumes one unit of the budget.
+    /// @retval false if the budget is exhausted.
+    bool consume() noexcept {
+        if (remaining_ == 0)
+            return false;
+        --remaining_;
+        return true;
+    }
+
+    /// Restores the full budget (e.g. before resuming the next coroutine).
+    void refill() noexcept { remaining_ = limit_; }
+
+    /// Enqueues `item.handle` at the back of the queue of the current worker
+    /// and refills the budget.
+    /// @note   `item` may be dequeued (and its coroutine resumed) by another
+    ///         thread before this function returns.
+    virtual void yield(work_item &item) noexcept = 0;
+
+  protected:
+    explicit resumption_budget(std::size_t limit) noexcept : limit_(limit), remaining_(limit) {}
+    ~resumption_budget() = default;
+
+  private:
+    static inline thread_local resumption_budget *current_ = nullptr;
+    const std::size_t limit_;
+    std::size_t remaining_;
+};
+
+/// Returns @p next to be resumed by symmetric transfer or, if the budget of
+/// the current thread is exhausted, yields it (using @p item, which must
+/// outlive its resumption, as the queue node) and returns a no-op coroutine.
+inline std::coroutine_handle<> transfer_within_budget(std::coroutine_handle<> next,
+                                                      work_item &item) noexcept {
+    resumption_budget *budget = resumption_budget::current();
+    if (!budget || budget->consume())
+        return next;
+    item.handle = next;
+    budget->yield(item);
+    return std::noop_coroutine();
+}
+
+} // namespace mp_coro::detail
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <mp-coro/bits/frame_allocation.h>
 #include <mp-coro/bits/noncopyable.h>
 #include <mp-coro/bits/task_promise_storage.h>
 #include <mp-coro/coro_ptr.h>
@@ -45,7 +46,9 @@ class [[nodiscard]] synchronized_task {
     /// Stores the value produced by the @ref synchronized_task, and a pointer
     /// to the “sync” object, a variable to notify after completion of the
     /// @ref synchronized_task.
-    struct promise_type : private detail::noncopyable, task_promise_storage<T> {
+    struct promise_type : private detail::noncopyable,
+                          frame_allocation<promise_type>,
+                          task_promise_storage<T> {
         /// Pointer to the “sync” object to notify of our completion.
         Sync *sync = nullptr;
 
@@ -93,6 +96,14 @@ class [[nodiscard]] synchronized_task {
         std::coroutine_handle<promise_type>::from_promise(*promise_).resume();
     }
 
+    /// Attaches the “sync” object like @ref start() does, but returns the
+    /// handle that starts the %task instead of resuming it (e.g. to resume it
+    /// on a scheduler).
+    [[nodiscard]] std::coroutine_handle<> prepare(Sync &s) noexcept {
+        promise_->sync = &s;
+        return std::coroutine_handle<promise_type>::from_promise(*promise_);
+    }
+
     /// Get the value produced by this %task.
     /// Must be called after the “sync” object passed to @ref start() has been
     /// notified.
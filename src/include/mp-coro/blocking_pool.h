@@ -0,0 +1,312 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/storage.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace mp_coro {
+
+/// Pool of threads for blocking calls (file I/O, legacy synchronous APIs,
+/// etc.), kept apart from the compute schedulers so that the blocking calls
+/// never occupy their workers.
+///
+/// The pool starts with `min_threads` threads. When work is submitted and no
+/// thread is idle, a new thread is started, up to `max_threads` (beyond that,
+/// the work is queued). Threads that stay idle for `idle_timeout` exit, down
+/// to `min_threads`.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> handle(thread_pool &compute) {
+///     // read on a blocking thread, then continue on the compute pool
+///     auto data = co_await (async_blocking([] { return read_config(); }) | resume_on(compute));
+///     // ...
+/// }
+/// ```
+class blocking_pool : private detail::noncopyable {
+  public:
+    /// Node of the intrusive queue of the pool: `execute` is called on one of
+    /// the threads of the pool.
+    class job {
+      protected:
+        explicit job(void (*execute)(job &) noexcept) noexcept : execute_(execute) {}
+
+      private:
+        friend blocking_pool;
+        void (*execute_)(job &) noexcept;
+        job *next_ = nullptr;
+    };
+
+    /// Awaiter returned by @ref schedule().
+    class schedule_operation : private job {
+      public:
+        explicit schedule_operation(blocking_pool &pool) noexcept
+            : job(&resume_awaiting), pool_(pool) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Enqueues the awaiting coroutine to be resumed on a blocking thread.
+        void await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            handle_ = handle;
+            pool_.submit(*this);
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        static void resume_awaiting(job &j) noexcept {
+            static_cast<schedule_operation &>(j).handle_.resume();
+        }
+
+        blocking_pool &pool_;
+        std::coroutine_handle<> handle_;
+    };
+
+    /// @param  max_threads   Maximum number of threads (at least one).
+    /// @param  idle_timeout  Time after which an idle thread exits.
+    /// @param  min_threads   Number of threads that are kept even if idle.
+    explicit blocking_pool(std::size_t max_threads = 512,
+                           std::chrono::milliseconds idle_timeout = std::chrono::seconds(10),
+                           std::size_t min_threads = 0)
+        : max_threads_(std::max<std::size_t>(max_threads, 1)),
+          min_threads_(std::min(min_threads, max_threads_)),
+          idle_timeout_(idle_timeout) {
+        std::lock_guard lock(mutex_);
+        while (thread_count_ < min_threads_)
+            start_thread();
+    }
+
+    /// Lets the threads finish all the work that is still queued and waits for
+    /// them to exit.
+    ~blocking_pool() {
+        std::list<std::thread> finished;
+        {
+            std::unique_lock lock(mutex_);
+            stopping_ = true;
+            work_cv_.notify_all();
+            exit_cv_.wait(lock, [&] { return thread_count_ == 0; });
+            finished = std::move(finished_);
+        }
+        for (auto &t : finished)
+            t.join();
+    }
+
+    /// Pool used by the @ref async_blocking awaitables that do not name one.
+    [[nodiscard]] static blocking_pool &global() {
+        static blocking_pool pool;
+        return pool;
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on one of the
+    /// threads of the pool.
+    [[nodiscard]] schedule_operation schedule() noexcept { return schedule_operation {*this}; }
+
+    /// Runs @p j on one of the threads of the pool, starting a new thread if
+    /// none is idle.
+    /// @throws std::system_error if a thread can't be started, in which case
+    ///         @p j is not queued.
+    void submit(job &j) {
+        std::lock_guard lock(mutex_);
+        j.next_ = nullptr; // jobs may be submitted again after they ran
+        job *const prev = tail_;
+        if (prev)
+            prev->next_ = &j;
+        else
+            head_ = &j;
+        tail_ = &j;
+        ++queued_;
+        if (idle_ >= queued_)
+            work_cv_.notify_one();
+        else if (thread_count_ < max_threads_) {
+            try {
+                start_thread();
+            } catch (...) {
+                // still the tail, as the lock is held
+                if (prev)
+                    prev->next_ = nullptr;
+                else
+                    head_ = nullptr;
+                tail_ = prev;
+                --queued_;
+                throw;
+            }
+        }
+    }
+
+    /// Current number of threads.
+    [[nodiscard]] std::size_t thread_count() const {
+        std::lock_guard lock(mutex_);
+        return thread_count_;
+    }
+
+  private:
+    /// @pre `mutex_` is locked.
+    void start_thread() {
+        // reap the threads that exited on their idle timeout
+        for (auto &t : finished_)
+            t.join();
+        finished_.clear();
+        const auto self = threads_.emplace(threads_.end());
+        try {
+            *self = std::thread([this, self] { run(self); }); // `run()` waits for the lock
+        } catch (...) {
+            threads_.erase(self); // would be joined, but was never started
+            throw;
+        }
+        ++thread_count_;
+    }
+
+    void run(std::list<std::thread>::iterator self) {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            if (head_) {
+                job &j = *std::exchange(head_, head_->next_);
+                if (!head_)
+                    tail_ = nullptr;
+                --queued_;
+                lock.unlock();
+                j.execute_(j);
+                lock.lock();
+                continue;
+            }
+            if (stopping_)
+                break;
+            ++idle_;
+            const bool woken =
+                work_cv_.wait_for(lock, idle_timeout_, [&] { return head_ || stopping_; });
+            --idle_;
+            if (!woken && thread_count_ > min_threads_)
+                break;
+        }
+        --thread_count_;
+        finished_.splice(finished_.end(), threads_, self); // joined by someone else
+        exit_cv_.notify_all();
+    }
+
+    const std::size_t max_threads_;
+    const std::size_t min_threads_;
+    const std::chrono::milliseconds idle_timeout_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable exit_cv_;
+    job *head_ = nullptr;
+    job *tail_ = nullptr;
+    std::size_t queued_ = 0;
+    std::size_t idle_ = 0;
+    std::size_t thread_count_ = 0;
+    bool stopping_ = false;
+    std::list<std::thread> threads_;  // running
+    std::list<std::thread> finished_; // exited, but not joined yet
+};
+
+/// Awaitable that calls a blocking function on a thread of a
+/// @ref blocking_pool (the global one by default), and resumes the awaiting
+/// coroutine on that thread with the result (or the exception thrown).
+///
+/// Use @ref resume_on() to continue on a compute scheduler afterwards.
+template <std::invocable Func>
+class async_blocking : private blocking_pool::job {
+  public:
+    using return_type = std::invoke_result_t<Func>;
+
+    template <typename F>
+        requires std::same_as<std::remove_cvref_t<F>, Func>
+    explicit async_blocking(F &&func)
+        : async_blocking(blocking_pool::global(), std::forward<F>(func)) {}
+
+    template <typename F>
+        requires std::same_as<std::remove_cvref_t<F>, Func>
+    async_blocking(blocking_pool &pool, F &&func)
+        : job(&execute), pool_(pool), func_ {std::forward<F>(func)} {}
+
+    decltype(auto) operator co_await() & = delete; // awaited only once (as an rvalue)
+    decltype(auto) operator co_await() && {
+        struct awaiter {
+            async_blocking &awaitable;
+
+            static bool await_ready() noexcept {
+                TRACE_FUNC();
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                TRACE_FUNC();
+                awaitable.handle_ = handle;
+                awaitable.pool_.submit(awaitable);
+            }
+
+            decltype(auto) await_resume() {
+                TRACE_FUNC();
+                return std::move(awaitable.result_).get();
+            }
+        };
+        return awaiter {*this};
+    }
+
+  private:
+    static void execute(blocking_pool::job &j) noexcept {
+        TRACE_FUNC();
+        auto &self = static_cast<async_blocking &>(j);
+        try {
+            if constexpr (std::is_void_v<return_type>)
+                self.func_();
+            else
+                self.result_.set_value(self.func_());
+        } catch (...) {
+            self.result_.set_exception(std::current_exception());
+        }
+        self.handle_.resume();
+    }
+
+    blocking_pool &pool_;
+    Func func_;
+    detail::storage<return_type> result_;
+    std::coroutine_handle<> handle_;
+};
+
+template <typename F>
+async_blocking(F) -> async_blocking<F>;
+
+template <typename F>
+async_blocking(blocking_pool &, F) -> async_blocking<F>;
+
+} // namespace mp_coro
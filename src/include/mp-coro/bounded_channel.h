@@ -0,0 +1,253 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace mp_coro {
+
+/// Queue of at most `capacity` values of type `T` between coroutines:
+/// @ref push() suspends the producer while the queue is full and @ref pop()
+/// suspends the consumer while it is empty, which bounds the memory used by
+/// a fast producer.
+///
+/// The values are kept in a ring buffer allocated up front. Suspended
+/// producers and consumers wait in intrusive FIFO lists of their awaiters.
+/// A waiting coroutine is resumed inline by the one that unblocks it, on its
+/// thread, after the lock is released.
+///
+/// @ref close() ends the stream: the values already queued can still be
+/// popped, after which @ref pop() produces `std::nullopt`, and @ref push()
+/// fails right away.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> produce(bounded_channel<row> &ch) {
+///     while (auto r = co_await read_row())
+///         if (!co_await ch.push(std::move(*r)))
+///             break; // closed by the consumer
+///     ch.close();
+/// }
+///
+/// task<> consume(bounded_channel<row> &ch) {
+///     while (std::optional<row> r = co_await ch.pop())
+///         process(*r);
+/// }
+/// ```
+template <std::move_constructible T>
+class bounded_channel : private detail::noncopyable {
+  public:
+    /// Awaiter returned by @ref push(). Produces `false` if the channel is
+    /// closed (and the value was not queued).
+    class push_operation {
+      public:
+        push_operation(bounded_channel &ch, T value) : channel_(ch), value_(std::move(value)) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            std::unique_lock lock(channel_.mutex_);
+            if (channel_.closed_)
+                return false;
+            if (pop_operation *consumer = channel_.consumers_.pop()) {
+                // the buffer is empty: hand the value over directly
+                consumer->value_.emplace(std::move(value_));
+                lock.unlock();
+                consumer->handle_.resume();
+                pushed_ = true;
+                return false;
+            }
+            if (channel_.size_ < channel_.buffer_.size()) {
+                channel_.put(std::move(value_));
+                pushed_ = true;
+                return false;
+            }
+            handle_ = handle;
+            channel_.producers_.push(this);
+            return true;
+        }
+
+        [[nodiscard]] bool await_resume() const noexcept {
+            TRACE_FUNC();
+            return pushed_;
+        }
+
+      private:
+        friend bounded_channel;
+        bounded_channel &channel_;
+        T value_;
+        bool pushed_ = false;
+        std::coroutine_handle<> handle_;
+        push_operation *next_ = nullptr;
+    };
+
+    /// Awaiter returned by @ref pop(). Produces `std::nullopt` if the channel
+    /// is closed and empty.
+    class pop_operation {
+      public:
+        explicit pop_operation(bounded_channel &ch) noexcept : channel_(ch) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            std::unique_lock lock(channel_.mutex_);
+            if (channel_.size_ != 0) {
+                value_.emplace(channel_.take());
+                // make room for the first waiting producer
+                if (push_operation *producer = channel_.producers_.pop()) {
+                    channel_.put(std::move(producer->value_));
+                    producer->pushed_ = true;
+                    lock.unlock();
+                    producer->handle_.resume();
+                }
+                return false;
+            }
+            if (channel_.closed_)
+                return false;
+            handle_ = handle;
+            channel_.consumers_.push(this);
+            return true;
+        }
+
+        std::optional<T> await_resume() {
+            TRACE_FUNC();
+            return std::move(value_);
+        }
+
+      private:
+        friend bounded_channel;
+        bounded_channel &channel_;
+        std::optional<T> value_;
+        std::coroutine_handle<> handle_;
+        pop_operation *next_ = nullptr;
+    };
+
+    /// Creates a channel that queues up to @p capacity values (at least one).
+    explicit bounded_channel(std::size_t capacity) : buffer_(std::max<std::size_t>(capacity, 1)) {}
+
+    /// @pre No coroutine is suspended on the channel.
+    ~bounded_channel() {
+        assert(!producers_.head && !consumers_.head && "bounded_channel destroyed while in use");
+    }
+
+    /// Returns an awaitable that queues @p value, suspending the awaiting
+    /// coroutine while the channel is full. Produces `false` if the channel is
+    /// closed.
+    [[nodiscard]] push_operation push(T value) { return push_operation(*this, std::move(value)); }
+
+    /// Returns an awaitable that produces the oldest value queued, suspending
+    /// the awaiting coroutine while the channel is empty. Produces
+    /// `std::nullopt` once the channel is closed and drained.
+    [[nodiscard]] pop_operation pop() noexcept { return pop_operation(*this); }
+
+    /// Closes the channel, resuming all the suspended consumers (with
+    /// `std::nullopt`) and producers (with `false`). Can be called more than
+    /// once and from both sides.
+    void close() {
+        std::unique_lock lock(mutex_);
+        closed_ = true;
+        pop_operation *consumers = std::exchange(consumers_.head, nullptr);
+        push_operation *producers = std::exchange(producers_.head, nullptr);
+        consumers_.tail = nullptr;
+        producers_.tail = nullptr;
+        lock.unlock();
+        // read `next_` before resuming, as it ends the lifetime of the awaiter
+        while (consumers)
+            std::exchange(consumers, consumers->next_)->handle_.resume();
+        while (producers)
+            std::exchange(producers, producers->next_)->handle_.resume();
+    }
+
+    /// Maximum number of values queued.
+    [[nodiscard]] std::size_t capacity() const noexcept { return buffer_.size(); }
+
+  private:
+    /// Intrusive FIFO of suspended awaiters.
+    template <typename Op>
+    struct wait_list {
+        Op *head = nullptr;
+        Op *tail = nullptr;
+
+        void push(Op *op) noexcept {
+            op->next_ = nullptr;
+            if (tail)
+                tail->next_ = op;
+            else
+                head = op;
+            tail = op;
+        }
+
+        Op *pop() noexcept {
+            Op *op = head;
+            if (op) {
+                head = op->next_;
+                if (!head)
+                    tail = nullptr;
+            }
+            return op;
+        }
+    };
+
+    void put(T &&value) {
+        buffer_[(first_ + size_) % buffer_.size()].emplace(std::move(value));
+        ++size_;
+    }
+
+    T take() {
+        std::optional<T> &slot = buffer_[first_];
+        T value = std::move(*slot);
+        slot.reset();
+        first_ = (first_ + 1) % buffer_.size();
+        --size_;
+        return value;
+    }
+
+    std::mutex mutex_;
+    std::vector<std::optional<T>> buffer_; // ring buffer
+    std::size_t first_ = 0;
+    std::size_t size_ = 0;
+    bool closed_ = false;
+    wait_list<push_operation> producers_; // waiting for room in the buffer
+    wait_list<pop_operation> consumers_;  // waiting for a value
+};
+
+} // namespace mp_coro
@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace mp_coro {
+
+/// Fixed number of equally sized buffers carved from a single aligned
+/// allocation made up front, recycled through a free list. Memory use stays
+/// constant however many times the buffers are reused.
+///
+/// Thread-safe: buffers can be acquired and released on any thread.
+class buffer_pool : private detail::noncopyable {
+  public:
+    /// @param  count        Number of buffers.
+    /// @param  buffer_size  Size of every buffer (rounded up to a multiple of
+    ///                      @p alignment).
+    /// @param  alignment    Alignment of every buffer (a power of 2).
+    buffer_pool(std::size_t count, std::size_t buffer_size,
+                std::size_t alignment = alignof(std::max_align_t))
+        : alignment_(alignment), buffer_size_((buffer_size + alignment - 1) & ~(alignment - 1)),
+          count_(count) {
+        assert(std::has_single_bit(alignment) && "alignment must be a power of 2");
+        storage_ = static_cast<std::byte *>(
+            ::operator new(count_ * buffer_size_, std::align_val_t {alignment_}));
+        free_.reserve(count_);
+        for (std::size_t i = count_; i-- > 0;)
+            free_.push_back(storage_ + i * buffer_size_);
+    }
+
+    ~buffer_pool() {
+        assert(free_.size() == count_ && "buffers still in use");
+        ::operator delete(storage_, std::align_val_t {alignment_});
+    }
+
+    /// Returns a free buffer of @ref buffer_size() bytes, or `nullptr` if all
+    /// of them are in use.
+    [[nodiscard]] std::byte *try_acquire() noexcept {
+        std::lock_guard lock(mutex_);
+        if (free_.empty())
+            return nullptr;
+        std::byte *buffer = free_.back();
+        free_.pop_back();
+        return buffer;
+    }
+
+    /// Returns @p buffer (obtained from @ref try_acquire()) to the pool.
+    void release(std::byte *buffer) noexcept {
+        assert(buffer >= storage_ && buffer < storage_ + count_ * buffer_size_);
+        std::lock_guard lock(mutex_);
+        free_.push_back(buffer); // never reallocates (reserved up front)
+    }
+
+    [[nodiscard]] std::size_t buffer_size() const noexcept { return buffer_size_; }
+    [[nodiscard]] std::size_t alignment() const noexcept { return alignment_; }
+    [[nodiscard]] std::size_t count() const noexcept { return count_; }
+
+    /// Number of buffers currently free.
+    [[nodiscard]] std::size_t available() const {
+        std::lock_guard lock(mutex_);
+        return free_.size();
+    }
+
+    /// The memory of all the buffers (e.g. to register it with the kernel).
+    [[nodiscard]] std::span<std::byte> storage() const noexcept {
+        return {storage_, count_ * buffer_size_};
+    }
+
+  private:
+    const std::size_t alignment_;
+    const std::size_t buffer_size_;
+    const std::size_t count_;
+    std::byte *storage_;
+    mutable std::mutex mutex_;
+    std::vector<std::byte *> free_;
+};
+
+} // namespace mp_coro
@@ -0,0 +1,167 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/bits/synchronized_task.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/when_all.h>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mp_coro {
+
+/// @ref scheduler that can enqueue many coroutines at once (e.g.
+/// @ref thread_pool).
+template <typename S>
+concept bulk_scheduler = scheduler<S> && requires(S &s, std::span<detail::work_item> items) {
+    s.schedule_bulk(items);
+};
+
+namespace detail {
+
+template <typename F>
+using bulk_result_t = std::invoke_result_t<F &, std::size_t>;
+
+template <typename F>
+synchronized_task<when_all_sync, bulk_result_t<F>> bulk_invoke(F &fn, std::size_t index) {
+    TRACE_FUNC();
+    co_return std::invoke(fn, index);
+}
+
+template <scheduler S, typename F>
+synchronized_task<when_all_sync, bulk_result_t<F>> bulk_schedule_invoke(S &sched, F &fn,
+                                                                       std::size_t index) {
+    TRACE_FUNC();
+    co_await sched.schedule();
+    co_return std::invoke(fn, index);
+}
+
+template <scheduler S, typename F>
+class bulk_awaitable {
+  public:
+    bulk_awaitable(S &sched, std::size_t count, F fn)
+        : sched_(sched), count_(count), fn_(std::move(fn)), sync_(count) {}
+
+    decltype(auto) operator co_await() & = delete; // awaited only once (as an rvalue)
+    decltype(auto) operator co_await() && {
+        struct awaiter {
+            bulk_awaitable &awaitable;
+
+            static bool await_ready() noexcept {
+                TRACE_FUNC();
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle) {
+                TRACE_FUNC();
+                awaitable.start();
+                return awaitable.sync_.set_continuation(handle);
+            }
+
+            decltype(auto) await_resume() {
+                TRACE_FUNC();
+                return make_all_results(std::move(awaitable.tasks_));
+            }
+        };
+        return awaiter {*this};
+    }
+
+  private:
+    void start() {
+        tasks_.reserve(count_);
+        if constexpr (bulk_scheduler<S>) {
+            for (std::size_t i = 0; i < count_; ++i)
+                tasks_.push_back(bulk_invoke(fn_, i));
+            items_.resize(count_);
+            for (std::size_t i = 0; i < count_; ++i)
+                items_[i].handle = tasks_[i].prepare(sync_);
+            sched_.schedule_bulk(std::span(items_));
+        } else {
+            for (std::size_t i = 0; i < count_; ++i)
+                tasks_.push_back(bulk_schedule_invoke(sched_, fn_, i));
+            for (auto &t : tasks_)
+                t.start(sync_);
+        }
+    }
+
+    S &sched_;
+    std::size_t count_;
+    F fn_;
+    std::vector<synchronized_task<when_all_sync, bulk_result_t<F>>> tasks_;
+    std::vector<work_item> items_;
+    when_all_sync sync_;
+};
+
+} // namespace detail
+
+/// Returns an awaitable that invokes `fn(i)` for every `i` in `[0, n)` on
+/// @p sched, and resumes the awaiting coroutine with the results in the order
+/// of `i` (a `std::vector`, or nothing if @p fn returns `void`). If any of the
+/// invocations throws, the first exception (in the order of `i`) is rethrown.
+///
+/// With a @ref bulk_scheduler all the invocations are enqueued in a single
+/// batch, which saves most of the queueing and wake-up costs of scheduling
+/// them one by one. Other schedulers are used through `schedule()`.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> render(thread_pool &pool, image &img) {
+///     std::vector<tile> tiles = co_await bulk_schedule(
+///         pool, img.tile_count(), [&](std::size_t i) { return render_tile(img, i); });
+///     // ...
+/// }
+/// ```
+template <scheduler S, std::invocable<std::size_t> F>
+[[nodiscard]] auto bulk_schedule(S &sched, std::size_t n, F fn) {
+    TRACE_FUNC();
+    return detail::bulk_awaitable<S, F>(sched, n, std::move(fn));
+}
+
+/// Returns an awaitable that invokes all the @p callables on @p sched in one
+/// batch (see @ref bulk_schedule()), and resumes the awaiting coroutine with
+/// their results in order.
+/// @note   Lvalue ranges are referenced, rvalue ones are moved into the
+///         awaitable.
+template <scheduler S, std::ranges::random_access_range R>
+    requires std::invocable<std::ranges::range_reference_t<R>>
+[[nodiscard]] auto async_bulk(S &sched, R &&callables) {
+    TRACE_FUNC();
+    const auto n = static_cast<std::size_t>(std::ranges::size(callables));
+    auto invoke_at = [r = std::views::all(std::forward<R>(callables))](
+                         std::size_t i) mutable -> decltype(auto) {
+        return std::invoke(std::ranges::begin(r)[static_cast<std::ptrdiff_t>(i)]);
+    };
+    return bulk_schedule(sched, n, std::move(invoke_at));
+}
+
+} // namespace mp_coro
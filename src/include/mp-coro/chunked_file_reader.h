@@ -0,0 +1,351 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/buffer_pool.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mp_coro {
+
+/// Streams a file of any size as a sequence of fixed-size chunks, with the
+/// memory use bounded by `(read_ahead + 1) * chunk_size`.
+///
+/// Up to `read_ahead` chunks are read ahead of the consumer, in parallel, on
+/// the threads of a @ref blocking_pool, into buffers of a @ref buffer_pool. A
+/// @ref chunk hands its buffer back to the pool when destroyed, for a read
+/// started by the following @ref next(). As long as the consumer is slower than the disk, the
+/// next chunk is ready when it asks for it, and @ref next() completes without
+/// suspending. Otherwise the consumer is resumed on the thread of the
+/// @ref blocking_pool that completed the read (use @ref resume_on() to
+/// continue elsewhere).
+///
+/// The reader must outlive all the chunks it produced. Its destructor waits
+/// for the reads still in flight.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<std::uint64_t> count_lines(const std::filesystem::path &path) {
+///     chunked_file_reader reader(path);
+///     std::uint64_t lines = 0;
+///     while (auto chunk = co_await reader.next())
+///         lines += std::ranges::count(chunk.text(), '\n');
+///     co_return lines;
+/// }
+/// ```
+class chunked_file_reader : private detail::noncopyable {
+    struct read_op;
+
+  public:
+    /// Data read from the file, referencing a buffer of the reader. Its
+    /// buffer is recycled when the chunk is destroyed. Empty (and `false`)
+    /// at the end of the file.
+    class chunk {
+      public:
+        chunk() = default;
+        chunk(chunk &&other) noexcept
+            : reader_(std::exchange(other.reader_, nullptr)), buffer_(other.buffer_),
+              size_(other.size_), offset_(other.offset_) {}
+        chunk &operator=(chunk &&other) noexcept {
+            if (this != &other) {
+                reset();
+                reader_ = std::exchange(other.reader_, nullptr);
+                buffer_ = other.buffer_;
+                size_ = other.size_;
+                offset_ = other.offset_;
+            }
+            return *this;
+        }
+        ~chunk() { reset(); }
+
+        [[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+            return {buffer_, size_};
+        }
+        [[nodiscard]] std::string_view text() const noexcept {
+            return {reinterpret_cast<const char *>(buffer_), size_};
+        }
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+        explicit operator bool() const noexcept { return !empty(); }
+
+        /// Position of the chunk in the file.
+        [[nodiscard]] std::uint64_t offset() const noexcept { return offset_; }
+
+        /// Returns the buffer to the reader early.
+        void reset() noexcept {
+            if (reader_)
+                std::exchange(reader_, nullptr)->recycle(buffer_);
+            size_ = 0;
+        }
+
+      private:
+        friend chunked_file_reader;
+        chunk(chunked_file_reader *reader, std::byte *buffer, std::size_t size,
+              std::uint64_t offset) noexcept
+            : reader_(reader), buffer_(buffer), size_(size), offset_(offset) {}
+
+        chunked_file_reader *reader_ = nullptr;
+        std::byte *buffer_ = nullptr;
+        std::size_t size_ = 0;
+        std::uint64_t offset_ = 0;
+    };
+
+    /// Awaiter returned by @ref next().
+    class next_operation {
+      public:
+        explicit next_operation(chunked_file_reader &reader) noexcept : reader_(reader) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Starts the reads into the buffers recycled since the last call.
+        /// Suspends only if the next chunk is still being read.
+        bool await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            std::lock_guard lock(reader_.mutex_);
+            reader_.issue_reads();
+            if (!reader_.next_pending())
+                return false;
+            reader_.waiting_ = handle;
+            return true;
+        }
+
+        chunk await_resume() {
+            TRACE_FUNC();
+            return reader_.take();
+        }
+
+      private:
+        chunked_file_reader &reader_;
+    };
+
+    /// Opens the file at @p path.
+    /// @param  chunk_size  Size of the chunks (the last one may be shorter).
+    /// @param  read_ahead  Maximum number of chunks read ahead of the consumer
+    ///                     (at least one).
+    /// @param  pool        Threads doing the reads.
+    /// @throws std::system_error if the file can't be opened.
+    explicit chunked_file_reader(const std::filesystem::path &path,
+                                 std::size_t chunk_size = std::size_t {1} << 20,
+                                 std::size_t read_ahead = 4,
+                                 blocking_pool &pool = blocking_pool::global())
+        : pool_(pool), chunk_size_(std::max<std::size_t>(chunk_size, 1)),
+          read_ahead_(std::max<std::size_t>(read_ahead, 1)),
+          buffers_(read_ahead_ + 1, chunk_size_),
+          slots_(read_ahead_) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0)
+            throw std::system_error(errno, std::system_category(), "open " + path.string());
+        struct ::stat st;
+        if (::fstat(fd_, &st) < 0) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::system_category(), "fstat " + path.string());
+        }
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        const auto size = static_cast<std::uint64_t>(st.st_size);
+        chunk_count_ = (size + chunk_size_ - 1) / chunk_size_;
+        for (auto &op : slots_)
+            op.reader = this;
+
+        try {
+            std::lock_guard lock(mutex_);
+            issue_reads();
+        } catch (...) {
+            shut_down(); // the reads already started reference `*this`
+            throw;
+        }
+    }
+
+    /// Waits for the reads still in flight.
+    ~chunked_file_reader() { shut_down(); }
+
+    /// Returns an awaitable producing the next @ref chunk of the file (an
+    /// empty one at the end of the file).
+    /// @throws std::system_error (when awaited) if the read failed.
+    [[nodiscard]] next_operation next() noexcept { return next_operation {*this}; }
+
+    [[nodiscard]] std::size_t chunk_size() const noexcept { return chunk_size_; }
+
+  private:
+    struct read_op : blocking_pool::job {
+        read_op() noexcept : job(&execute) {}
+
+        chunked_file_reader *reader = nullptr;
+        std::uint64_t seq = 0;
+        std::byte *buffer = nullptr;
+        std::size_t size = 0;
+        int error = 0;
+        bool complete = false;
+
+        static void execute(blocking_pool::job &j) noexcept {
+            TRACE_FUNC();
+            auto &op = static_cast<read_op &>(j);
+            chunked_file_reader &reader = *op.reader;
+            const std::size_t capacity = reader.chunk_size_;
+            const auto offset = op.seq * capacity;
+            std::size_t done = 0;
+            int error = 0;
+            while (done < capacity) {
+                const auto n = ::pread(reader.fd_, op.buffer + done, capacity - done,
+                                       static_cast<::off_t>(offset + done));
+                if (n > 0)
+                    done += static_cast<std::size_t>(n);
+                else if (n == 0)
+                    break; // end of file
+                else if (errno != EINTR) {
+                    error = errno;
+                    break;
+                }
+            }
+
+            std::coroutine_handle<> consumer;
+            {
+                std::lock_guard lock(reader.mutex_);
+                op.size = done;
+                op.error = error;
+                op.complete = true;
+                if (reader.waiting_ && reader.consumed_ == op.seq)
+                    consumer = std::exchange(reader.waiting_, {});
+                if (--reader.in_flight_ == 0)
+                    reader.idle_.notify_all();
+            }
+            if (consumer)
+                consumer.resume();
+        }
+    };
+
+    read_op &slot(std::uint64_t seq) noexcept { return slots_[seq % read_ahead_]; }
+
+    /// Whether the consumer has to wait for the read of the next chunk.
+    /// @pre `mutex_` is locked.
+    bool next_pending() noexcept {
+        // not issued yet only if the consumer holds all the buffers
+        return consumed_ < chunk_count_ && consumed_ < issued_ && !slot(consumed_).complete;
+    }
+
+    /// Starts the reads of the following chunks, as far as the read-ahead
+    /// depth and the free buffers allow. A read is counted only once it is
+    /// submitted (it can't complete before `mutex_` is unlocked).
+    /// @pre `mutex_` is locked.
+    /// @throws std::system_error if a read can't be submitted; the reads
+    ///         started before are kept.
+    void issue_reads() {
+        while (issued_ < chunk_count_ && issued_ < consumed_ + read_ahead_) {
+            std::byte *buffer = buffers_.try_acquire();
+            if (!buffer)
+                break;
+            // the slot of a chunk already handed out
+            read_op &op = slot(issued_);
+            op.seq = issued_;
+            op.buffer = buffer;
+            op.complete = false;
+            try {
+                pool_.submit(op);
+            } catch (...) {
+                buffers_.release(buffer);
+                throw;
+            }
+            ++issued_;
+            ++in_flight_;
+        }
+    }
+
+    chunk take() {
+        std::lock_guard lock(mutex_);
+        if (consumed_ == chunk_count_)
+            return {};
+        if (consumed_ == issued_)
+            throw std::logic_error(
+                "chunked_file_reader: all the buffers are held by the consumer");
+        read_op &op = slot(consumed_++);
+        assert(op.complete);
+        if (op.error != 0) {
+            buffers_.release(op.buffer);
+            throw std::system_error(op.error, std::system_category(), "pread");
+        }
+        chunk result(this, op.buffer, op.size, (consumed_ - 1) * chunk_size_);
+        try {
+            issue_reads(); // keep reading ahead while the consumer processes the chunk
+        } catch (...) {
+            // retried (and reported) by the next `next()`, not to lose the chunk
+        }
+        return result;
+    }
+
+    /// Leaves starting the next read to @ref next(), which can report it if
+    /// it fails.
+    void recycle(std::byte *buffer) noexcept { buffers_.release(buffer); }
+
+    void shut_down() noexcept {
+        {
+            std::unique_lock lock(mutex_);
+            chunk_count_ = issued_; // no more reads
+            idle_.wait(lock, [&] { return in_flight_ == 0; });
+        }
+        for (std::uint64_t seq = consumed_; seq < issued_; ++seq)
+            buffers_.release(slot(seq).buffer);
+        ::close(fd_);
+    }
+
+    blocking_pool &pool_;
+    const std::size_t chunk_size_;
+    const std::size_t read_ahead_;
+    buffer_pool buffers_;
+    std::vector<read_op> slots_; // ring of the reads, indexed by `seq % read_ahead_`
+    int fd_ = -1;
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    std::uint64_t chunk_count_ = 0;
+    std::uint64_t issued_ = 0;   // reads started
+    std::uint64_t consumed_ = 0; // chunks handed out to the consumer
+    std::size_t in_flight_ = 0;
+    std::coroutine_handle<> waiting_;
+};
+
+} // namespace mp_coro
@@ -94,4 +94,12 @@ concept sync_notification_type = requires(Sync s) {
     s.notify_awaitable_completed();
 };
 
+/// Type that provides a `schedule()` member function returning an awaitable
+/// that resumes the awaiting coroutine on an execution context owned by the
+/// scheduler (e.g. one of the worker threads of a @ref thread_pool).
+template <typename S>
+concept scheduler = requires(S &s) {
+    { s.schedule() } -> awaitable;
+};
+
 } // namespace mp_coro
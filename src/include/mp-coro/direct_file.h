@@ -0,0 +1,208 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/blocking_pool.h>
+#include <mp-coro/buffer_pool.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mp_coro {
+
+/// Access mode of a @ref direct_file.
+enum class file_access {
+    read_only,
+    write_only, ///< Creates the file if it does not exist.
+    read_write  ///< Creates the file if it does not exist.
+};
+
+/// File opened with `O_DIRECT`: reads and writes go straight between the
+/// device and the user's buffers, bypassing the page cache, so large scans
+/// do not evict the hot data of other users from it.
+///
+/// Direct I/O requires the buffer addresses, the file offsets and the
+/// lengths to be multiples of @ref alignment(). Buffers with the right
+/// alignment come from @ref make_buffer_pool(). The reads and writes run on
+/// a @ref blocking_pool, and resume the awaiting coroutine on its thread.
+///
+/// As writes are done in whole blocks, use @ref truncate() to set the exact
+/// size of a written file.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<std::uint64_t> checksum(const std::filesystem::path &path) {
+///     direct_file file(path);
+///     auto buffers = file.make_buffer_pool(1, 1 << 20);
+///     std::byte *buffer = buffers.try_acquire();
+///     std::uint64_t sum = 0;
+///     for (std::uint64_t offset = 0;; offset += buffers.buffer_size()) {
+///         const std::size_t n = co_await file.read(offset, {buffer, buffers.buffer_size()});
+///         sum += checksum(std::span(buffer, n));
+///         if (n < buffers.buffer_size())
+///             break;
+///     }
+///     buffers.release(buffer);
+///     co_return sum;
+/// }
+/// ```
+class direct_file : private detail::noncopyable {
+  public:
+    /// Opens the file at @p path with `O_DIRECT`.
+    /// @throws std::system_error if the file can't be opened (with
+    ///         `std::errc::invalid_argument` if its file system does not
+    ///         support direct I/O, e.g. tmpfs).
+    explicit direct_file(const std::filesystem::path &path,
+                         file_access access = file_access::read_only,
+                         blocking_pool &pool = blocking_pool::global())
+        : pool_(pool) {
+        int flags = O_DIRECT | O_CLOEXEC;
+        switch (access) {
+        case file_access::read_only: flags |= O_RDONLY; break;
+        case file_access::write_only: flags |= O_WRONLY | O_CREAT; break;
+        case file_access::read_write: flags |= O_RDWR | O_CREAT; break;
+        }
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0)
+            throw std::system_error(errno, std::system_category(), "open " + path.string());
+        alignment_ = query_alignment(fd_);
+    }
+
+    direct_file(direct_file &&other) noexcept
+        : pool_(other.pool_), fd_(std::exchange(other.fd_, -1)), alignment_(other.alignment_) {}
+
+    ~direct_file() {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    /// Alignment required for the buffers, offsets and lengths of the I/O.
+    [[nodiscard]] std::size_t alignment() const noexcept { return alignment_; }
+
+    /// Returns a pool of @p count buffers of @p buffer_size bytes (rounded up
+    /// to @ref alignment()), aligned for the I/O on this file. The memory of
+    /// the pool is one contiguous region (@ref buffer_pool::storage()).
+    [[nodiscard]] buffer_pool make_buffer_pool(std::size_t count, std::size_t buffer_size) const {
+        return buffer_pool(count, buffer_size, alignment_);
+    }
+
+    /// Returns an awaitable that reads into @p buffer from @p offset and
+    /// produces the number of bytes read (less than `buffer.size()` only at
+    /// the end of the file).
+    /// @throws std::system_error (when awaited) if the read failed.
+    [[nodiscard]] auto read(std::uint64_t offset, std::span<std::byte> buffer) {
+        assert(aligned(offset, buffer.data(), buffer.size()));
+        return async_blocking(pool_, [fd = fd_, offset, buffer] {
+            std::size_t done = 0;
+            while (done < buffer.size()) {
+                const auto n = ::pread(fd, buffer.data() + done, buffer.size() - done,
+                                       static_cast<::off_t>(offset + done));
+                if (n == 0)
+                    break; // end of file
+                if (n < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::system_error(errno, std::system_category(), "pread");
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            return done;
+        });
+    }
+
+    /// Returns an awaitable that writes all of @p data at @p offset.
+    /// @throws std::system_error (when awaited) if the write failed.
+    [[nodiscard]] auto write(std::uint64_t offset, std::span<const std::byte> data) {
+        assert(aligned(offset, data.data(), data.size()));
+        return async_blocking(pool_, [fd = fd_, offset, data] {
+            std::size_t done = 0;
+            while (done < data.size()) {
+                const auto n = ::pwrite(fd, data.data() + done, data.size() - done,
+                                        static_cast<::off_t>(offset + done));
+                if (n < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::system_error(errno, std::system_category(), "pwrite");
+                }
+                done += static_cast<std::size_t>(n);
+            }
+        });
+    }
+
+    /// Current size of the file.
+    [[nodiscard]] std::uint64_t size() const {
+        struct ::stat st;
+        if (::fstat(fd_, &st) < 0)
+            throw std::system_error(errno, std::system_category(), "fstat");
+        return static_cast<std::uint64_t>(st.st_size);
+    }
+
+    /// Sets the size of the file to @p size (e.g. to trim the padding of the
+    /// last block written).
+    void truncate(std::uint64_t size) {
+        if (::ftruncate(fd_, static_cast<::off_t>(size)) < 0)
+            throw std::system_error(errno, std::system_category(), "ftruncate");
+    }
+
+    [[nodiscard]] int native_handle() const noexcept { return fd_; }
+
+  private:
+    /// Memory and offset alignment of direct I/O on @p fd, as reported by
+    /// `statx()` (Linux 6.1+), or the common page size otherwise.
+    static std::size_t query_alignment(int fd) noexcept {
+        std::size_t alignment = 4096;
+#if defined(STATX_DIOALIGN)
+        struct ::statx stx;
+        if (::statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+            (stx.stx_mask & STATX_DIOALIGN) != 0 && stx.stx_dio_offset_align != 0)
+            alignment = std::max<std::size_t>(stx.stx_dio_mem_align, stx.stx_dio_offset_align);
+#else
+        (void)fd;
+#endif
+        return alignment;
+    }
+
+    bool aligned(std::uint64_t offset, const void *data, std::size_t size) const noexcept {
+        const auto mask = alignment_ - 1;
+        return (offset & mask) == 0 && (reinterpret_cast<std::uintptr_t>(data) & mask) == 0 &&
+               (size & mask) == 0;
+    }
+
+    blocking_pool &pool_;
+    int fd_ = -1;
+    std::size_t alignment_ = 4096;
+};
+
+} // namespace mp_coro
@@ -0,0 +1,193 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/frame_allocation.h>
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/task_promise_storage.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/coro_ptr.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/type_traits.h>
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+
+namespace mp_coro {
+
+/// Task that starts executing as soon as it is created and produces a value of
+/// type `T`: to get that value, await the @ref eager_task.
+///
+/// Unlike @ref task, the coroutine runs on the calling thread until its first
+/// suspension point, so several independent @ref eager_task "eager tasks" that
+/// hop to other threads (e.g. with `co_await pool.schedule()`) overlap even if
+/// they are then awaited one by one.
+///
+/// The completion of the coroutine may race with the `co_await` of its
+/// result. The race is resolved with a single atomic word in the promise that
+/// is either empty, holds the address of the awaiting coroutine, or marks the
+/// @ref eager_task as completed: whoever comes second resumes the awaiting
+/// coroutine.
+///
+/// @pre    The @ref eager_task must be completed (e.g. awaited) before it is
+///         destroyed, as its coroutine may be running on another thread.
+///
+/// @par Example
+///
+/// ```cpp
+/// eager_task<int> fetch(thread_pool &pool, int i);
+///
+/// task<int> sum(thread_pool &pool) {
+///     auto a = fetch(pool, 1); // started
+///     auto b = fetch(pool, 2); // started
+///     co_return co_await a + co_await b;
+/// }
+/// ```
+///
+/// @ingroup coro_ret_types
+template <task_value_type T = void>
+class [[nodiscard]] eager_task {
+  public:
+    /// The type of the value produced by this @ref eager_task.
+    using value_type = T;
+
+    /// Required promise type for coroutines returning an @ref eager_task.
+    /// Stores the value produced by the @ref eager_task, and the state word
+    /// synchronizing its completion with the awaiting coroutine.
+    struct promise_type : private detail::noncopyable,
+                          detail::frame_allocation<promise_type>,
+                          detail::task_promise_storage<T> {
+        /// `nullptr` while running and not awaited, the address of the
+        /// awaiting coroutine once awaited, or @ref completed() once done.
+        std::atomic<void *> state = nullptr;
+
+        /// Value of @ref state that marks the coroutine as done. The address
+        /// of the promise can't be the address of the awaiting coroutine.
+        void *completed() noexcept { return this; }
+
+        /// Returns an @ref eager_task that references this promise.
+        eager_task get_return_object() noexcept {
+            TRACE_FUNC();
+            return this;
+        }
+
+        /// Eager: starts executing right away.
+        static std::suspend_never initial_suspend() noexcept {
+            TRACE_FUNC();
+            return {};
+        }
+
+        /// Awaiter returned by @ref final_suspend.
+        struct final_awaiter : std::suspend_always {
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<promise_type> this_coro) noexcept {
+                TRACE_FUNC();
+                auto &promise = this_coro.promise();
+                void *awaiting = promise.state.exchange(promise.completed(),
+                                                        std::memory_order_acq_rel);
+                return awaiting ? std::coroutine_handle<>::from_address(awaiting)
+                                : std::noop_coroutine();
+            }
+        };
+
+        /// Marks the @ref eager_task as done and resumes the awaiting
+        /// coroutine if it is already attached.
+        static awaiter_of<void> auto final_suspend() noexcept {
+            TRACE_FUNC();
+            return final_awaiter {};
+        }
+    };
+
+    eager_task(eager_task &&) = default;           ///< Move constructor.
+    eager_task &operator=(eager_task &&) = delete; ///< Move assignment not allowed.
+
+    /// Returns `true` if the coroutine has completed, i.e. awaiting the
+    /// @ref eager_task would not suspend.
+    [[nodiscard]] bool is_ready() const noexcept {
+        return promise_->state.load(std::memory_order_acquire) == promise_->completed();
+    }
+
+  private:
+    /// Awaiter type for awaiting the result of an @ref eager_task.
+    struct awaiter {
+        /// Reference to the promise object of the @ref eager_task in question.
+        promise_type &promise;
+
+        /// Returns true if the @ref eager_task's coroutine is already done.
+        bool await_ready() const noexcept {
+            TRACE_FUNC();
+            return promise.state.load(std::memory_order_acquire) == promise.completed();
+        }
+
+        /// Attaches the current coroutine to be resumed on completion.
+        /// @retval false if the @ref eager_task completed in the meantime and
+        ///         the current coroutine should continue right away.
+        bool await_suspend(std::coroutine_handle<> h) const noexcept {
+            TRACE_FUNC();
+            void *expected = nullptr;
+            return promise.state.compare_exchange_strong(
+                expected, h.address(), std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /// Return the value of the @ref eager_task's promise.
+        decltype(auto) await_resume() const {
+            TRACE_FUNC();
+            return promise.get();
+        }
+    };
+
+  public:
+    /// When awaited, suspends the current coroutine until the @ref eager_task
+    /// completes (if it didn't already).
+    awaiter_of<T> auto operator co_await() const &noexcept {
+        TRACE_FUNC();
+        return awaiter(*promise_);
+    }
+
+    awaiter_of<const T &> auto
+    operator co_await() const &noexcept requires std::move_constructible<T> {
+        TRACE_FUNC();
+        return awaiter(*promise_);
+    }
+
+    awaiter_of<T &&> auto operator co_await() const &&noexcept requires std::move_constructible<T> {
+        TRACE_FUNC();
+
+        struct rvalue_awaiter : awaiter {
+            T &&await_resume() {
+                TRACE_FUNC();
+                return std::move(this->promise).get();
+            }
+        };
+        return rvalue_awaiter({*promise_});
+    }
+
+  private:
+    /// An owning pointer to the promise object in the coroutine frame.
+    promise_ptr<promise_type> promise_;
+
+    /// Private constructor used in @ref promise_type::get_return_object.
+    eager_task(promise_type *promise) : promise_(promise) { TRACE_FUNC(); }
+};
+
+} // namespace mp_coro
@@ -0,0 +1,230 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace mp_coro {
+
+/// Scheduler that shares its worker threads between tenants in proportion to
+/// their weights, so a noisy tenant can't monopolize the workers.
+///
+/// Every tenant has its own FIFO queue, and the workers pick the next
+/// coroutine to resume with Deficit Round Robin: the tenants with pending work
+/// take turns, each turn credits the tenant with `quantum * weight` of
+/// execution time, and the tenant is served until the credit is used up. The
+/// time a resumed coroutine runs (until it suspends again) is charged to its
+/// tenant afterwards, so tenants are isolated in terms of CPU time, not only
+/// in the number of resumptions.
+///
+/// @par Example
+///
+/// ```cpp
+/// fair_thread_pool pool(8, std::array<std::uint32_t, 2>{3, 1}); // 75% / 25%
+///
+/// task<> handle(fair_thread_pool &pool, tenant_id tenant) {
+///     co_await pool.schedule(tenant);
+///     // ...
+/// }
+/// ```
+class fair_thread_pool : private detail::noncopyable {
+  public:
+    using tenant_id = std::size_t;
+
+    /// Awaiter returned by @ref schedule(). Also serves as the node of the
+    /// intrusive tenant queues.
+    class schedule_operation {
+      public:
+        schedule_operation(fair_thread_pool &pool, tenant_id tenant) noexcept
+            : pool_(pool), tenant_(tenant) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Enqueues the awaiting coroutine in the queue of its tenant.
+        void await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            handle_ = handle;
+            pool_.enqueue(this);
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        friend fair_thread_pool;
+        fair_thread_pool &pool_;
+        tenant_id tenant_;
+        std::coroutine_handle<> handle_;
+        schedule_operation *next_ = nullptr;
+    };
+
+    /// Starts @p thread_count worker threads (at least one) shared by
+    /// `weights.size()` tenants with the given relative weights.
+    /// @param  quantum  Execution time credited to a tenant of weight 1 per
+    ///                  round.
+    fair_thread_pool(std::size_t thread_count, std::span<const std::uint32_t> weights,
+                     std::chrono::nanoseconds quantum = std::chrono::microseconds(100))
+        : quantum_(quantum), tenants_(weights.size()) {
+        for (std::size_t i = 0; i < weights.size(); ++i)
+            tenants_[i].weight = std::max<std::uint32_t>(weights[i], 1);
+        thread_count = std::max<std::size_t>(thread_count, 1);
+        threads_.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i)
+            threads_.emplace_back([this](std::stop_token stop) { run(stop); });
+    }
+
+    /// Lets the workers finish all the work that is still queued and joins
+    /// them.
+    ~fair_thread_pool() {
+        for (auto &t : threads_)
+            t.request_stop();
+        threads_.clear();
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on one of the
+    /// worker threads, on behalf of @p tenant.
+    [[nodiscard]] schedule_operation schedule(tenant_id tenant) noexcept {
+        assert(tenant < tenants_.size() && "unknown tenant");
+        return schedule_operation {*this, tenant};
+    }
+
+    /// Changes the weight of @p tenant (takes effect from its next turn).
+    void set_weight(tenant_id tenant, std::uint32_t weight) {
+        std::lock_guard lock(mutex_);
+        tenants_[tenant].weight = std::max<std::uint32_t>(weight, 1);
+    }
+
+    /// Number of worker threads.
+    [[nodiscard]] std::size_t thread_count() const noexcept { return threads_.size(); }
+
+    /// Number of tenants.
+    [[nodiscard]] std::size_t tenant_count() const noexcept { return tenants_.size(); }
+
+  private:
+    struct tenant_state {
+        schedule_operation *head = nullptr;
+        schedule_operation *tail = nullptr;
+        std::uint32_t weight = 1;
+        bool active = false; // in active_
+        /// Execution time left in the current turn (negative when overrun).
+        /// Atomic as it is charged by the workers without holding the lock.
+        std::atomic<std::int64_t> deficit = 0;
+    };
+
+    void enqueue(schedule_operation *op) {
+        {
+            std::lock_guard lock(mutex_);
+            tenant_state &t = tenants_[op->tenant_];
+            if (t.tail)
+                t.tail->next_ = op;
+            else
+                t.head = op;
+            t.tail = op;
+            if (!t.active) {
+                t.active = true;
+                active_.push_back(op->tenant_);
+            }
+        }
+        cv_.notify_one();
+    }
+
+    /// Deficit Round Robin over the tenants that have pending work.
+    /// Returns `nullptr` if the queues of all the active tenants turned out to
+    /// be empty.
+    /// @pre `mutex_` is locked.
+    schedule_operation *pick(tenant_id &id) {
+        while (!active_.empty()) {
+            id = active_.front();
+            tenant_state &t = tenants_[id];
+            if (t.head && t.deficit.load(std::memory_order_relaxed) > 0) {
+                schedule_operation *op = t.head;
+                t.head = op->next_;
+                if (!t.head)
+                    t.tail = nullptr;
+                return op;
+            }
+            // end of the turn of this tenant
+            active_.pop_front();
+            if (t.head) {
+                t.deficit.fetch_add(quantum_.count() * t.weight, std::memory_order_relaxed);
+                active_.push_back(id);
+            } else {
+                // idle tenants do not accumulate credit (but keep their debt)
+                t.active = false;
+                auto d = t.deficit.load(std::memory_order_relaxed);
+                while (d > 0 &&
+                       !t.deficit.compare_exchange_weak(d, 0, std::memory_order_relaxed)) {}
+            }
+        }
+        return nullptr;
+    }
+
+    void run(std::stop_token stop) {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            cv_.wait(lock, stop, [&] { return !active_.empty(); });
+            if (active_.empty())
+                break; // stop requested and no work left
+            tenant_id id;
+            schedule_operation *op = pick(id);
+            if (!op)
+                continue;
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            op->handle_.resume();
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            tenants_[id].deficit.fetch_sub(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                std::memory_order_relaxed);
+
+            lock.lock();
+        }
+    }
+
+    const std::chrono::nanoseconds quantum_;
+    std::vector<tenant_state> tenants_;
+    std::deque<tenant_id> active_; // tenants with pending work in round robin order
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::vector<std::jthread> threads_; // must be the last member (joined first)
+};
+
+} // namespace mp_coro
@@ -0,0 +1,174 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mp_coro {
+
+namespace detail {
+
+/// Returns the human readable name of type `T` as spelled by the compiler.
+template <typename T>
+constexpr std::string_view type_name() noexcept {
+    // GCC:   "... type_name() [with T = <type>; std::string_view = ...]"
+    // Clang: "... type_name() [T = <type>]"
+    std::string_view name = std::source_location::current().function_name();
+    const auto begin = name.find("T = ");
+    if (begin == std::string_view::npos)
+        return name;
+    const auto end = name.find_first_of(";]", begin + 4);
+    return name.substr(begin + 4, end - begin - 4);
+}
+
+/// Size of the last coroutine frame allocated on the current thread.
+inline thread_local std::size_t last_frame_size = 0;
+
+} // namespace detail
+
+/// Size of the coroutine frames allocated for a single coroutine function.
+struct frame_record {
+    std::string_view function;  ///< Coroutine function (as reported by `std::source_location`).
+    std::string_view file;      ///< Source file of the coroutine function.
+    std::uint_least32_t line;   ///< Line of the coroutine function.
+    std::string_view promise;   ///< Promise type of the coroutine.
+    std::size_t size;           ///< Largest frame size requested, in bytes.
+    std::size_t allocations;    ///< Number of frames allocated.
+};
+
+/// Process-wide registry of the coroutine frame sizes.
+///
+/// Populated by the `operator new` of the promise types of this library when
+/// compiled with `MP_CORO_FRAME_STATS` defined to a non-zero value (the
+/// `MP_CORO_FRAME_STATS` CMake option). The compiler passes the size of the
+/// whole frame (promise, parameters, and all the locals that live across
+/// suspension points) to that operator, so that is the size recorded here.
+///
+/// @note `MP_CORO_FRAME_STATS` must be set consistently across all the
+///       translation units of a program.
+class frame_stats {
+  public:
+    [[nodiscard]] static frame_stats &instance() {
+        static frame_stats stats;
+        return stats;
+    }
+
+    void record(std::size_t size, const std::source_location &loc, std::string_view promise) {
+        detail::last_frame_size = size;
+        std::lock_guard lock(mutex_);
+        auto [it, inserted] = records_.try_emplace(
+            key {loc.file_name(), loc.line(), promise},
+            frame_record {loc.function_name(), loc.file_name(), loc.line(), promise, size, 0});
+        it->second.size = std::max(it->second.size, size);
+        ++it->second.allocations;
+    }
+
+    /// Returns all the records, largest frames first.
+    [[nodiscard]] std::vector<frame_record> snapshot() const {
+        std::vector<frame_record> result;
+        {
+            std::lock_guard lock(mutex_);
+            result.reserve(records_.size());
+            for (const auto &[_, r] : records_)
+                result.push_back(r);
+        }
+        std::ranges::stable_sort(result, std::ranges::greater {}, &frame_record::size);
+        return result;
+    }
+
+    /// Prints a table of all the records, largest frames first.
+    void report(std::ostream &os) const {
+        os << std::right << std::setw(10) << "size [B]" << std::setw(12) << "frames"
+           << "  coroutine\n";
+        for (const auto &r : snapshot())
+            os << std::setw(10) << r.size << std::setw(12) << r.allocations << "  " << r.function
+               << " (" << r.file << ':' << r.line << ")\n"
+               << std::setw(24) << "" << "promise: " << r.promise << '\n';
+    }
+
+    void reset() {
+        std::lock_guard lock(mutex_);
+        records_.clear();
+    }
+
+  private:
+    using key = std::tuple<std::string_view, std::uint_least32_t, std::string_view>;
+    frame_stats() = default;
+    mutable std::mutex mutex_;
+    std::map<key, frame_record> records_;
+};
+
+/// Thrown by @ref require_frame_budget.
+class frame_budget_exceeded : public std::length_error {
+  public:
+    using std::length_error::length_error;
+};
+
+/// Calls the coroutine function @p f with @p args and returns the size of the
+/// coroutine frame it allocated. The returned coroutine object is destroyed
+/// right away, so @p f should be a lazy coroutine (e.g. @ref task or
+/// @ref generator) for its body not to run.
+///
+/// @returns 0 if the frame allocation was elided or `MP_CORO_FRAME_STATS` is
+///          not enabled.
+template <typename F, typename... Args>
+requires std::invocable<F, Args...>
+[[nodiscard]] std::size_t frame_size_of(F &&f, Args &&...args) {
+    detail::last_frame_size = 0;
+    (void)std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+    return detail::last_frame_size;
+}
+
+/// Helper for tests: throws @ref frame_budget_exceeded if the frame of the
+/// coroutine created by `f(args...)` is larger than `Budget` bytes.
+///
+/// ```cpp
+/// require_frame_budget<256>(parse_header, buffer);
+/// ```
+template <std::size_t Budget, typename F, typename... Args>
+requires std::invocable<F, Args...>
+std::size_t require_frame_budget(F &&f, Args &&...args) {
+    const auto size = frame_size_of(std::forward<F>(f), std::forward<Args>(args)...);
+    if (size > Budget)
+        throw frame_budget_exceeded("coroutine frame of " + std::to_string(size)
+                                    + " bytes exceeds the budget of " + std::to_string(Budget)
+                                    + " bytes");
+    return size;
+}
+
+} // namespace mp_coro
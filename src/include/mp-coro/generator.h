@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <mp-coro/bits/frame_allocation.h>
 #include <mp-coro/bits/noncopyable.h>
 #include <mp-coro/coro_ptr.h>
 #include <mp-coro/trace.h>
@@ -30,21 +31,79 @@
 #include <coroutine>
 #include <optional>
 #include <ranges>
+#include <type_traits>
 #include <utility>
 
 namespace mp_coro {
 
-/// @ingroup coro_ret_types
+/// Where a @ref generator keeps the values yielded by its coroutine.
+enum class yield_storage {
+    /// The promise points to the yielded object, which lives in the coroutine
+    /// (a temporary lives until the generator is resumed). The consumer gets
+    /// read-only access to it.
+    reference,
+    /// The yielded object is moved (or copied) into the promise. The consumer
+    /// gets mutable access to it and can take ownership with `std::move(*it)`.
+    value
+};
+
+namespace detail {
+
+template <typename T, yield_storage Storage>
+struct generator_yield {
+    using reference = std::conditional_t<std::is_reference_v<T>, T,
+                                         const std::remove_reference_t<T> &>;
+
+    std::add_pointer_t<reference> value;
+
+    std::suspend_always yield_value(reference v) noexcept {
+        TRACE_FUNC();
+        value = std::addressof(v);
+        return {};
+    }
+    [[nodiscard]] reference get() const noexcept { return *value; }
+};
+
 template <typename T>
+struct generator_yield<T, yield_storage::value> {
+    static_assert(!std::is_reference_v<T>, "Only objects can be yielded by value");
+    using reference = T &;
+
+    std::optional<T> value;
+
+    template <typename U = T>
+        requires std::constructible_from<T, U>
+    std::suspend_always yield_value(U &&v) noexcept(std::is_nothrow_constructible_v<T, U>) {
+        TRACE_FUNC();
+        value.emplace(std::forward<U>(v));
+        return {};
+    }
+    [[nodiscard]] reference get() noexcept { return *value; }
+};
+
+} // namespace detail
+
+/// @ingroup coro_ret_types
+///
+/// With `yield_storage::value` the yielded values are stored in the promise,
+/// so yielding a temporary never dangles and the consumer may move from it:
+///
+/// ```cpp
+/// generator<std::vector<row>, yield_storage::value> batches(source &src);
+///
+/// for (auto &batch : batches(src))
+///     sink.push(std::move(batch)); // no copy
+/// ```
+template <typename T, yield_storage Storage = yield_storage::reference>
 class [[nodiscard]] generator {
   public:
     using value_type = std::remove_reference_t<T>;
-    using reference = std::conditional_t<std::is_reference_v<T>, T, const value_type &>;
+    using reference = typename detail::generator_yield<T, Storage>::reference;
     using pointer = std::add_pointer_t<reference>;
 
-    struct promise_type : private detail::noncopyable {
-        pointer value;
-
+    struct promise_type : private detail::noncopyable,
+                          detail::frame_allocation<promise_type>,
+                          detail::generator_yield<T, Storage> {
         static std::suspend_always initial_suspend() noexcept {
             TRACE_FUNC();
             return {};
@@ -59,11 +118,6 @@ class [[nodiscard]] generator {
             TRACE_FUNC();
             return this;
         }
-        std::suspend_always yield_value(reference v) noexcept {
-            TRACE_FUNC();
-            value = std::addressof(v);
-            return {};
-        }
         void unhandled_exception() {
             TRACE_FUNC();
             throw;
@@ -104,7 +158,7 @@ class [[nodiscard]] generator {
         [[nodiscard]] reference operator*() const noexcept {
             TRACE_FUNC();
             assert(!handle_.done() && "Can't dereference generator end iterator");
-            return *handle_.promise().value;
+            return handle_.promise().get();
         }
         [[nodiscard]] pointer operator->() const noexcept {
             TRACE_FUNC();
@@ -143,5 +197,5 @@ class [[nodiscard]] generator {
 
 } // namespace mp_coro
 
-template <typename T>
-inline constexpr bool std::ranges::enable_view<mp_coro::generator<T>> = true;
+template <typename T, mp_coro::yield_storage Storage>
+inline constexpr bool std::ranges::enable_view<mp_coro::generator<T, Storage>> = true;
@@ -0,0 +1,442 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/generator.h>
+#include <mp-coro/trace.h>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Range adaptors for @ref mp_coro::generator "generators" (and other input
+/// ranges) that fuse into a single loop.
+///
+/// Chaining `std::views` over a generator walks every element through all the
+/// iterators of the chain, each of them reaching into the generator's promise
+/// on dereference. The adaptors of this namespace are composed instead into a
+/// chain of stages that runs in the increment of one iterator: it pulls each
+/// element from the source once and passes it through all the stages with
+/// direct (inlined) calls:
+///
+/// ```cpp
+/// for (const auto &batch : read_rows(file)
+///                              | fused::filter([](const row &r) { return r.valid; })
+///                              | fused::map(&row::id)
+///                              | fused::chunk(256)
+///                              | fused::take(10))
+///     db.delete_ids(batch);
+/// ```
+///
+/// No coroutine is added on top of the source generator. Values computed by
+/// the stages are stored in the @ref view; elements passed through unchanged
+/// are referenced in place.
+namespace mp_coro::fused {
+
+namespace detail {
+
+template <typename F>
+struct map_stage {
+    template <typename In>
+    using output = std::invoke_result_t<F &, In>;
+
+    F fn;
+
+    template <typename V, typename K>
+    void step(V &&v, K &&next) {
+        next(std::invoke(fn, std::forward<V>(v)));
+    }
+};
+
+template <typename P>
+struct filter_stage {
+    template <typename In>
+    using output = In;
+
+    P pred;
+
+    template <typename V, typename K>
+    void step(V &&v, K &&next) {
+        if (std::invoke(pred, std::as_const(v)))
+            next(std::forward<V>(v));
+    }
+};
+
+struct take_stage {
+    template <typename In>
+    using output = In;
+
+    std::size_t count;
+    std::size_t taken = 0;
+
+    template <typename V, typename K>
+    void step(V &&v, K &&next) {
+        if (taken < count) {
+            ++taken;
+            next(std::forward<V>(v));
+        }
+    }
+    [[nodiscard]] bool done() const noexcept { return taken >= count; }
+};
+
+template <typename T>
+struct chunk_stage {
+    template <typename In>
+    using output = std::vector<T>;
+
+    std::size_t size;
+    std::vector<T> buffer = {};
+
+    template <typename V, typename K>
+    void step(V &&v, K &&next) {
+        if (buffer.empty())
+            buffer.reserve(size);
+        buffer.emplace_back(std::forward<V>(v));
+        if (buffer.size() == size)
+            next(std::exchange(buffer, {}));
+    }
+    template <typename K>
+    void flush(K &&next) {
+        if (!buffer.empty())
+            next(std::exchange(buffer, {}));
+    }
+};
+
+template <typename Stage>
+concept finite_stage = requires(const Stage &s) {
+    { s.done() } -> std::convertible_to<bool>;
+};
+
+template <typename Stage>
+concept buffering_stage = requires(Stage &s) {
+    s.flush([](auto &&) {});
+};
+
+template <typename In, typename... Stages>
+struct chain_output {
+    using type = In;
+};
+
+template <typename In, typename Stage, typename... Stages>
+struct chain_output<In, Stage, Stages...>
+    : chain_output<typename Stage::template output<In>, Stages...> {};
+
+/// Compile-time chain of stages, applied in continuation-passing style: every
+/// stage passes its outputs on to the rest of the chain, and each element
+/// produces at most one output (or none).
+template <typename In, typename... Stages>
+class chain {
+  public:
+    /// Type of the elements reaching the end of the chain.
+    using output_reference = typename chain_output<In, Stages...>::type;
+    using output = std::remove_cvref_t<output_reference>;
+    static constexpr std::size_t size = sizeof...(Stages);
+
+    explicit chain(std::tuple<Stages...> stages) : stages_(std::move(stages)) {}
+
+    template <std::size_t I = 0, typename V, typename Sink>
+    void step(V &&v, Sink &sink) {
+        if constexpr (I == sizeof...(Stages))
+            sink(std::forward<V>(v));
+        else
+            std::get<I>(stages_).step(std::forward<V>(v), [&](auto &&out) {
+                step<I + 1>(std::forward<decltype(out)>(out), sink);
+            });
+    }
+
+    /// Whether no more elements would pass through the chain.
+    [[nodiscard]] bool done() const {
+        return std::apply(
+            [](const auto &...stages) {
+                return (... || [&] {
+                    if constexpr (finite_stage<std::remove_cvref_t<decltype(stages)>>)
+                        return stages.done();
+                    else
+                        return false;
+                }());
+            },
+            stages_);
+    }
+
+    [[nodiscard]] std::tuple<Stages...> &&stages() && noexcept { return std::move(stages_); }
+
+    /// Passes what stage @p index holds back (at most one output) to the rest
+    /// of the chain.
+    template <typename Sink>
+    void flush(std::size_t index, Sink &sink) {
+        flush_at(index, sink, std::index_sequence_for<Stages...> {});
+    }
+
+  private:
+    template <typename Sink, std::size_t... Is>
+    void flush_at(std::size_t index, Sink &sink, std::index_sequence<Is...>) {
+        (..., [&] {
+            if constexpr (buffering_stage<std::tuple_element_t<Is, std::tuple<Stages...>>>)
+                if (index == Is)
+                    std::get<Is>(stages_).flush([&](auto &&out) {
+                        step<Is + 1>(std::forward<decltype(out)>(out), sink);
+                    });
+        }());
+    }
+
+    std::tuple<Stages...> stages_;
+};
+
+struct chunk_adaptor {
+    std::size_t size;
+};
+
+template <typename In, typename Adaptor>
+auto make_stage(Adaptor adaptor) {
+    if constexpr (std::same_as<Adaptor, chunk_adaptor>)
+        return chunk_stage<std::remove_cvref_t<In>> {adaptor.size};
+    else
+        return adaptor;
+}
+
+template <typename T>
+inline constexpr bool is_adaptor = false;
+
+template <typename F>
+inline constexpr bool is_adaptor<map_stage<F>> = true;
+
+template <typename P>
+inline constexpr bool is_adaptor<filter_stage<P>> = true;
+
+template <>
+inline constexpr bool is_adaptor<take_stage> = true;
+
+template <>
+inline constexpr bool is_adaptor<chunk_adaptor> = true;
+
+template <typename T>
+concept adaptor = is_adaptor<T>;
+
+} // namespace detail
+
+/// Input range of the elements of `R` passed through a chain of stages (see
+/// @ref mp_coro::fused). Can be iterated once.
+template <std::ranges::input_range R, typename... Stages>
+class [[nodiscard]] view {
+    using chain_type = detail::chain<std::ranges::range_reference_t<R>, Stages...>;
+
+    /// Lvalues reaching the end of the chain refer to the elements of the
+    /// source, which outlive the increment of the source iterator (deferred
+    /// until the next element); they are referenced in place.
+    static constexpr bool by_reference =
+        std::is_lvalue_reference_v<typename chain_type::output_reference>;
+
+  public:
+    using value_type = typename chain_type::output;
+    using reference = std::conditional_t<by_reference, typename chain_type::output_reference,
+                                         value_type &>;
+
+    class iterator {
+      public:
+        using value_type = view::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator &operator++() {
+            view_->next();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        /// The values computed by the stages can be moved out.
+        [[nodiscard]] reference operator*() const noexcept {
+            assert(!view_->finished_ && "Can't dereference fused::view end iterator");
+            return view_->current();
+        }
+        [[nodiscard]] std::add_pointer_t<reference> operator->() const noexcept {
+            return std::addressof(operator*());
+        }
+
+        [[nodiscard]] bool operator==(std::default_sentinel_t) const noexcept {
+            return view_->finished_;
+        }
+
+      private:
+        friend view;
+        explicit iterator(view *v) noexcept : view_(v) {}
+        view *view_ = nullptr;
+    };
+    static_assert(std::input_iterator<iterator>);
+
+    view(R source, std::tuple<Stages...> stages)
+        : source_(std::move(source)), chain_(std::move(stages)) {}
+
+    view(view &&other) noexcept(std::is_nothrow_move_constructible_v<R> &&
+                                std::is_nothrow_move_constructible_v<chain_type>)
+        : source_(std::move(other.source_)), chain_(std::move(other.chain_)) {
+        assert(!other.it_ && "Can't move a fused::view being iterated");
+    }
+
+    /// Pulls elements from the source until the first one that gets through
+    /// the chain.
+    [[nodiscard]] iterator begin() {
+        TRACE_FUNC();
+        assert(!it_ && "fused::view can be iterated only once");
+        it_.emplace(std::ranges::begin(source_));
+        pull();
+        return iterator(this);
+    }
+    [[nodiscard]] std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+    /// Appends a stage to the chain.
+    template <detail::adaptor A>
+    friend auto operator|(view v, A adaptor) {
+        assert(!v.it_ && "Can't extend a fused::view being iterated");
+        auto stage = detail::make_stage<typename chain_type::output_reference>(std::move(adaptor));
+        return view<R, Stages..., decltype(stage)>(
+            std::move(v.source_),
+            std::tuple_cat(std::move(v.chain_).stages(), std::make_tuple(std::move(stage))));
+    }
+
+  private:
+    /// Computed values are assigned to a slot of the view when `value_type`
+    /// allows, so that storing one is not more than a (move) assignment.
+    using slot_type =
+        std::conditional_t<by_reference, std::add_pointer_t<reference>,
+                           std::conditional_t<std::default_initializable<value_type> &&
+                                                  std::movable<value_type>,
+                                              value_type, std::optional<value_type>>>;
+
+    /// Receives the outputs of the chain (at most one per step).
+    struct sink {
+        view &self;
+
+        template <typename V>
+        void operator()(V &&out) const {
+            if constexpr (by_reference)
+                self.slot_ = std::addressof(out);
+            else if constexpr (std::same_as<slot_type, value_type>)
+                self.slot_ = std::forward<V>(out);
+            else
+                self.slot_.emplace(std::forward<V>(out));
+            self.produced_ = true;
+        }
+    };
+
+    [[nodiscard]] reference current() noexcept {
+        if constexpr (std::same_as<slot_type, value_type>)
+            return slot_;
+        else
+            return *slot_;
+    }
+
+    /// Moves past the current element and pulls the next one.
+    void next() {
+        // the source element of the current one (if any) is no longer referenced
+        if (flush_index_ == 0 && !chain_.done())
+            ++*it_;
+        pull();
+    }
+
+    void pull() {
+        produced_ = false;
+        // pull the source until an element gets through the chain, or no more would
+        if (flush_index_ == 0) {
+            auto &it = *it_;
+            while (!chain_.done() && it != std::ranges::end(source_)) {
+                chain_.step(*it, sink_);
+                if (produced_)
+                    return;
+                if (!chain_.done())
+                    ++it;
+            }
+        }
+        // then drain what the stages hold back
+        while (flush_index_ != chain_type::size) {
+            chain_.flush(flush_index_++, sink_);
+            if (produced_)
+                return;
+        }
+        finished_ = true;
+    }
+
+    R source_;
+    chain_type chain_;
+    std::optional<std::ranges::iterator_t<R>> it_;
+    std::size_t flush_index_ = 0;
+    bool produced_ = false;
+    bool finished_ = false;
+    slot_type slot_ = {};
+    sink sink_ {*this};
+};
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool is_view = false;
+
+template <typename R, typename... Stages>
+inline constexpr bool is_view<view<R, Stages...>> = true;
+
+/// Starts a chain of stages over @p range (e.g. a @ref mp_coro::generator).
+/// Lvalue ranges are referenced, rvalue ones are moved into the chain.
+/// (Found by ADL through the type of the adaptor.)
+template <std::ranges::viewable_range R, adaptor A>
+    requires std::ranges::input_range<R> && (!is_view<std::remove_cvref_t<R>>)
+auto operator|(R &&range, A adaptor) {
+    using source = std::views::all_t<R>;
+    auto stage = make_stage<std::ranges::range_reference_t<source>>(std::move(adaptor));
+    return view<source, decltype(stage)>(std::views::all(std::forward<R>(range)),
+                                          std::make_tuple(std::move(stage)));
+}
+
+} // namespace detail
+
+/// Stage that transforms every element with @p fn.
+template <typename F>
+[[nodiscard]] detail::map_stage<F> map(F fn) {
+    return {std::move(fn)};
+}
+
+/// Stage that passes on only the elements that satisfy @p pred.
+template <typename P>
+[[nodiscard]] detail::filter_stage<P> filter(P pred) {
+    return {std::move(pred)};
+}
+
+/// Stage that passes on the first @p count elements, after which the source
+/// is not advanced any more.
+[[nodiscard]] inline detail::take_stage take(std::size_t count) noexcept { return {count}; }
+
+/// Stage that groups the elements into `std::vector`s of @p size elements
+/// (the last one possibly shorter).
+[[nodiscard]] inline detail::chunk_adaptor chunk(std::size_t size) noexcept {
+    assert(size > 0 && "chunk size must be positive");
+    return {size};
+}
+
+} // namespace mp_coro::fused
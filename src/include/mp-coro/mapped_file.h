@@ -0,0 +1,217 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/generator.h>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#include <string>
+#endif
+
+namespace mp_coro {
+
+/// Read-only memory mapping of a whole file, advised for sequential access
+/// (`MADV_SEQUENTIAL`), so that the kernel reads ahead aggressively and drops
+/// the pages behind the reader early.
+///
+/// On platforms without `mmap()` the file is read into memory instead.
+class mapped_file : private detail::noncopyable {
+  public:
+    /// Maps the file at @p path.
+    /// @throws std::system_error if the file can't be opened or mapped.
+    explicit mapped_file(const std::filesystem::path &path) {
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::system_category(), "open " + path.string());
+        struct ::stat st;
+        if (::fstat(fd, &st) < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "fstat " + path.string());
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) { // empty files can't be mapped
+            void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::system_category(), "mmap " + path.string());
+            }
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(data);
+        }
+        ::close(fd); // the mapping keeps the file open
+#else
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+            throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                                    "open " + path.string());
+        contents_.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        data_ = contents_.data();
+        size_ = contents_.size();
+#endif
+    }
+
+    mapped_file(mapped_file &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {
+#if !defined(__unix__) && !defined(__APPLE__)
+        contents_ = std::move(other.contents_);
+        if (data_)
+            data_ = contents_.data(); // small strings are stored in the object
+#endif
+    }
+
+    ~mapped_file() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data_)
+            ::munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+
+    /// Contents of the file. Valid as long as the mapping lives (also after
+    /// it is moved).
+    [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+#if !defined(__unix__) && !defined(__APPLE__)
+    std::string contents_;
+#endif
+};
+
+namespace detail {
+
+// Bit `i` of `newline_mask(p)` is set if `p[i]` is a newline.
+#if defined(__AVX2__)
+inline constexpr std::size_t newline_block = 32;
+
+inline std::uint32_t newline_mask(const char *p) noexcept {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return static_cast<std::uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))));
+}
+#elif defined(__SSE2__)
+inline constexpr std::size_t newline_block = 16;
+
+inline std::uint32_t newline_mask(const char *p) noexcept {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))));
+}
+#else
+inline constexpr std::size_t newline_block = 8;
+
+inline std::uint32_t newline_mask(const char *p) noexcept {
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < newline_block; ++i)
+        mask |= static_cast<std::uint32_t>(p[i] == '\n') << i;
+    return mask;
+}
+#endif
+
+inline std::string_view text_of(std::string_view text) noexcept { return text; }
+inline std::string_view text_of(const mapped_file &file) noexcept { return file.view(); }
+
+/// Scans the text of @p source a block at a time and yields the lines found
+/// in the block's newline mask. The text is taken from the copy of @p source
+/// in the coroutine frame, which keeps its memory alive (the contents of a
+/// @ref mapped_file may be stored in the object itself).
+template <typename Source>
+generator<std::string_view> lines(Source source) {
+    const std::string_view text = text_of(source);
+    const char *line = text.data();
+    const char *p = text.data();
+    const char *const end = p + text.size();
+    for (; static_cast<std::size_t>(end - p) >= newline_block; p += newline_block) {
+        for (std::uint32_t mask = newline_mask(p); mask != 0; mask &= mask - 1) {
+            const char *newline = p + std::countr_zero(mask);
+            co_yield std::string_view(line, static_cast<std::size_t>(newline - line));
+            line = newline + 1;
+        }
+    }
+    for (; p != end; ++p) {
+        if (*p == '\n') {
+            co_yield std::string_view(line, static_cast<std::size_t>(p - line));
+            line = p + 1;
+        }
+    }
+    if (line != end)
+        co_yield std::string_view(line, static_cast<std::size_t>(end - line));
+}
+
+} // namespace detail
+
+/// Generator of the lines of @p text (without the `'\n'`; a `'\r'` before it
+/// is kept). A final line without a newline is yielded too, an empty one
+/// is not.
+///
+/// The newlines are found a block of 32 (AVX2), 16 (SSE2) or 8 (scalar)
+/// bytes at a time, depending on the instruction set the code is compiled
+/// for (e.g. `-mavx2` or `-march=native` enables the AVX2 path).
+[[nodiscard]] inline generator<std::string_view> lines(std::string_view text) {
+    return detail::lines(text);
+}
+
+/// Generator of the lines of the file at @p path (see @ref lines()).
+///
+/// The file is memory-mapped, so the lines are views into the page cache:
+/// nothing is copied, and a multi-GB file is scanned at memory bandwidth. The
+/// views are valid as long as the generator lives.
+///
+/// @throws std::system_error (from the call) if the file can't be mapped.
+///
+/// @par Example
+///
+/// ```cpp
+/// std::size_t errors = 0;
+/// for (std::string_view line : mapped_lines("/var/log/app.log"))
+///     errors += line.starts_with("ERROR");
+/// ```
+[[nodiscard]] inline generator<std::string_view>
+mapped_lines(const std::filesystem::path &path) {
+    return detail::lines(mapped_file(path));
+}
+
+} // namespace mp_coro
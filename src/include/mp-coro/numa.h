@@ -0,0 +1,363 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace mp_coro {
+
+/// Returned by @ref this_numa_node() on threads that are not bound to a NUMA
+/// node.
+inline constexpr std::size_t no_numa_node = std::numeric_limits<std::size_t>::max();
+
+/// CPU set and NUMA node of a worker thread.
+struct worker_affinity {
+    std::size_t node = no_numa_node; ///< NUMA node the worker belongs to.
+    std::vector<unsigned> cpus;      ///< CPUs the worker may run on (all if empty).
+};
+
+namespace detail {
+
+/// NUMA node of the current thread (see @ref bind_current_thread()).
+inline thread_local std::size_t current_numa_node = no_numa_node;
+
+/// Parses a Linux CPU list (e.g. `"0-3,8-11"`). Malformed entries are skipped.
+inline std::vector<unsigned> parse_cpu_list(std::string_view list) {
+    std::vector<unsigned> cpus;
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        std::string_view range = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        while (!range.empty() && (range.back() == '\n' || range.back() == ' '))
+            range.remove_suffix(1);
+        unsigned first = 0;
+        const char *end = range.data() + range.size();
+        auto result = std::from_chars(range.data(), end, first);
+        unsigned last = first;
+        if (result.ec == std::errc {} && result.ptr != end && *result.ptr == '-')
+            result = std::from_chars(result.ptr + 1, end, last);
+        if (result.ec != std::errc {} || result.ptr != end || last < first)
+            continue;
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/// CPUs the current process is allowed to run on.
+inline std::vector<unsigned> allowed_cpus() {
+    std::vector<unsigned> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        return cpus;
+    }
+#endif
+    for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1U); ++cpu)
+        cpus.push_back(cpu);
+    return cpus;
+}
+
+/// Restricts the current thread to @p affinity.cpus (if any, Linux only) and
+/// binds it to @p affinity.node for the frame allocation.
+inline void bind_current_thread(const worker_affinity &affinity) noexcept {
+#if defined(__linux__)
+    if (!affinity.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const unsigned cpu : affinity.cpus)
+            if (cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    current_numa_node = affinity.node;
+}
+
+/// Pools of coroutine frames, one per NUMA node.
+///
+/// A thread bound to a node allocates frames from the pool of its node. The
+/// pools carve their blocks from fresh memory on the allocating thread, so
+/// with the first-touch policy of the OS the pages end up on that node. Every
+/// block has a small header recording its pool, so frames can be freed on any
+/// thread. The threads keep a small cache of free blocks of their own node,
+/// so that in the common case allocation does not take a lock.
+///
+/// Frames allocated on unbound threads, and large ones, come from the global
+/// `operator new`. The pools never return their memory to the OS.
+class numa_frame_pool : private noncopyable {
+  public:
+    [[nodiscard]] static numa_frame_pool &instance() {
+        static numa_frame_pool pool;
+        return pool;
+    }
+
+    [[nodiscard]] void *allocate(std::size_t size) {
+        const std::size_t node = current_numa_node;
+        const std::size_t cls = size_class(size);
+        if (node >= max_nodes || cls >= class_count) {
+            auto *h = static_cast<header *>(::operator new(size + sizeof(header)));
+            h->node = unpooled;
+            return h + 1;
+        }
+        thread_cache &cache = local_cache();
+        if (cache.node == node && cache.count[cls] != 0) {
+            --cache.count[cls];
+            return std::exchange(cache.free[cls], cache.free[cls]->next);
+        }
+        return arenas_[node].allocate(node, cls);
+    }
+
+    void deallocate(void *ptr, std::size_t size) noexcept {
+        header *h = static_cast<header *>(ptr) - 1;
+        if (h->node == unpooled) {
+            ::operator delete(h, size + sizeof(header));
+            return;
+        }
+        const std::size_t cls = size_class(size);
+        auto *block = static_cast<free_block *>(ptr);
+        thread_cache &cache = local_cache();
+        if (cache.node == current_numa_node && cache.node == h->node &&
+            cache.count[cls] < cache_limit) {
+            ++cache.count[cls];
+            block->next = std::exchange(cache.free[cls], block);
+            return;
+        }
+        arenas_[h->node].deallocate(block, cls);
+    }
+
+  private:
+    static constexpr std::size_t max_nodes = 64;
+    static constexpr std::size_t min_block = 64; // including the header
+    static constexpr std::size_t class_count = 7; // 64 B ... 4 KiB
+    static constexpr std::size_t cache_limit = 64; // blocks per size class
+    static constexpr std::size_t chunk_size = std::size_t {1} << 20;
+    static constexpr std::uint32_t unpooled = std::numeric_limits<std::uint32_t>::max();
+
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) header {
+        std::uint32_t node;
+    };
+
+    struct free_block {
+        free_block *next;
+    };
+
+    static std::size_t size_class(std::size_t size) noexcept {
+        const std::size_t block = std::bit_ceil(std::max(size + sizeof(header), min_block));
+        return static_cast<std::size_t>(std::countr_zero(block) - std::countr_zero(min_block));
+    }
+
+    static std::size_t block_size(std::size_t cls) noexcept { return min_block << cls; }
+
+    struct alignas(64) arena {
+        std::mutex mutex;
+        std::array<free_block *, class_count> free {};
+        std::byte *chunk = nullptr;
+        std::byte *chunk_end = nullptr;
+
+        void *allocate(std::size_t node, std::size_t cls) {
+            std::lock_guard lock(mutex);
+            if (free_block *block = free[cls]) {
+                free[cls] = block->next;
+                return block;
+            }
+            const std::size_t size = block_size(cls);
+            if (static_cast<std::size_t>(chunk_end - chunk) < size) {
+                chunk = static_cast<std::byte *>(allocate_chunk());
+                chunk_end = chunk + chunk_size;
+            }
+            // first touch happens here, on a thread of the node
+            auto *h = new (chunk) header {static_cast<std::uint32_t>(node)};
+            chunk += size;
+            return h + 1;
+        }
+
+        void deallocate(free_block *block, std::size_t cls) noexcept {
+            std::lock_guard lock(mutex);
+            block->next = std::exchange(free[cls], block);
+        }
+    };
+
+    static void *allocate_chunk() {
+#if defined(__linux__)
+        void *p = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        return p;
+#else
+        return ::operator new(chunk_size);
+#endif
+    }
+
+    /// Free blocks of a single node, owned by a thread.
+    struct thread_cache {
+        std::size_t node = no_numa_node;
+        std::array<free_block *, class_count> free {};
+        std::array<std::size_t, class_count> count {};
+
+        ~thread_cache() {
+            if (node >= max_nodes)
+                return;
+            for (std::size_t cls = 0; cls < class_count; ++cls)
+                while (free[cls])
+                    instance().arenas_[node].deallocate(std::exchange(free[cls], free[cls]->next),
+                                                        cls);
+        }
+    };
+
+    /// Cache of the current thread, flushed if the thread moved to another
+    /// node.
+    thread_cache &local_cache() noexcept {
+        static thread_local thread_cache cache;
+        if (cache.node != current_numa_node) {
+            for (std::size_t cls = 0; cls < class_count && cache.node < max_nodes; ++cls)
+                for (; cache.free[cls]; --cache.count[cls])
+                    arenas_[cache.node].deallocate(
+                        std::exchange(cache.free[cls], cache.free[cls]->next), cls);
+            cache.node = current_numa_node;
+        }
+        return cache;
+    }
+
+    numa_frame_pool() = default;
+    std::array<arena, max_nodes> arenas_;
+};
+
+} // namespace detail
+
+/// Returns the NUMA node the current thread is bound to (e.g. as a worker of
+/// a @ref thread_pool), or @ref no_numa_node.
+[[nodiscard]] inline std::size_t this_numa_node() noexcept { return detail::current_numa_node; }
+
+/// NUMA nodes of the machine and their CPUs, as visible to the process.
+///
+/// Discovered from `/sys/devices/system/node` (Linux); elsewhere, or if that
+/// fails, the machine is seen as a single node with all the CPUs.
+///
+/// @par Example
+///
+/// ```cpp
+/// const auto topology = numa_topology::discover();
+/// thread_pool pool(topology.place_workers(16)); // pinned and grouped by node
+/// ```
+class numa_topology {
+  public:
+    struct node {
+        std::size_t id;
+        std::vector<unsigned> cpus;
+    };
+
+    [[nodiscard]] static numa_topology
+    discover(const std::filesystem::path &sysfs = "/sys/devices/system/node") {
+        numa_topology topology;
+        const std::vector<unsigned> allowed = detail::allowed_cpus();
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(sysfs, ec)) {
+            const std::string name = entry.path().filename().string();
+            std::size_t id = 0;
+            if (!name.starts_with("node") ||
+                std::from_chars(name.data() + 4, name.data() + name.size(), id).ec != std::errc {})
+                continue;
+            std::ifstream file(entry.path() / "cpulist");
+            std::string list;
+            if (!std::getline(file, list))
+                continue;
+            std::vector<unsigned> cpus;
+            for (const unsigned cpu : detail::parse_cpu_list(list))
+                if (std::ranges::binary_search(allowed, cpu))
+                    cpus.push_back(cpu);
+            if (!cpus.empty()) // memory-only nodes, or not allowed by the affinity mask
+                topology.nodes_.push_back({id, std::move(cpus)});
+        }
+        if (topology.nodes_.empty())
+            topology.nodes_.push_back({0, allowed});
+        std::ranges::sort(topology.nodes_, {}, &node::id);
+        return topology;
+    }
+
+    [[nodiscard]] const std::vector<node> &nodes() const noexcept { return nodes_; }
+
+    /// Returns the node of @p cpu, or @ref no_numa_node.
+    [[nodiscard]] std::size_t node_of(unsigned cpu) const noexcept {
+        for (const auto &n : nodes_)
+            if (std::ranges::binary_search(n.cpus, cpu))
+                return n.id;
+        return no_numa_node;
+    }
+
+    /// Distributes @p thread_count workers over the nodes in proportion to
+    /// their number of CPUs. The workers of a node are consecutive, and each
+    /// one is restricted to the CPUs of its node (or to a single CPU of it if
+    /// @p pin_to_cpu is set).
+    [[nodiscard]] std::vector<worker_affinity> place_workers(std::size_t thread_count,
+                                                             bool pin_to_cpu = false) const {
+        std::size_t total_cpus = 0;
+        for (const auto &n : nodes_)
+            total_cpus += n.cpus.size();
+        std::vector<worker_affinity> workers;
+        workers.reserve(thread_count);
+        std::size_t assigned_cpus = 0;
+        for (const auto &n : nodes_) {
+            assigned_cpus += n.cpus.size();
+            // rounded, so that the total is exact
+            const std::size_t end = (thread_count * assigned_cpus + total_cpus / 2) / total_cpus;
+            for (std::size_t i = 0; workers.size() < end; ++i)
+                workers.push_back({n.id, pin_to_cpu ? std::vector {n.cpus[i % n.cpus.size()]}
+                                                    : n.cpus});
+        }
+        return workers;
+    }
+
+  private:
+    std::vector<node> nodes_;
+};
+
+} // namespace mp_coro
@@ -0,0 +1,304 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/concepts.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/when_all.h>
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace mp_coro {
+
+/// Lets the parallel algorithms choose the grain size.
+inline constexpr std::size_t auto_grain = 0;
+
+/// @ref scheduler that tells whether its current worker should split off work
+/// for the others (e.g. @ref thread_pool), which enables lazy binary
+/// splitting in the parallel algorithms.
+template <typename S>
+concept lazy_splitting_scheduler = scheduler<S> && requires(const S &s) {
+    { s.is_starving() } -> std::convertible_to<bool>;
+};
+
+namespace detail {
+
+template <scheduler S>
+std::size_t worker_count(S &sched) {
+    std::size_t workers = 0;
+    if constexpr (requires { { sched.thread_count() } -> std::convertible_to<std::size_t>; })
+        workers = sched.thread_count();
+    else
+        workers = std::thread::hardware_concurrency();
+    return std::max<std::size_t>(workers, 1);
+}
+
+/// Splits `[0, n)` into about 8 chunks per worker of @p sched, which leaves
+/// enough slack for load balancing while keeping the number of tasks small.
+template <scheduler S>
+std::size_t default_grain(S &sched, std::size_t n) {
+    return std::max<std::size_t>(n / (8 * worker_count(sched)), 1);
+}
+
+/// Applies @p leaf to the sub-ranges of `[first, last)` of at most @p grain
+/// elements and joins their results with @p combine.
+///
+/// Splits recursively in halves: the left half is forked (scheduled on
+/// @p sched, where idle workers can pick it up) while the current thread
+/// carries on with the right half, and both are joined with @ref when_all().
+template <typename T, scheduler S, typename Leaf, typename Combine>
+task<T> fork_join(S &sched, std::size_t first, std::size_t last, std::size_t grain, Leaf &leaf,
+                  Combine &combine, bool fork) {
+    TRACE_FUNC();
+    if (fork)
+        co_await sched.schedule();
+    if (last - first <= grain)
+        co_return leaf(first, last);
+    const std::size_t mid = first + (last - first) / 2;
+    if constexpr (std::is_void_v<T>) {
+        co_await when_all(fork_join<T>(sched, first, mid, grain, leaf, combine, true),
+                          fork_join<T>(sched, mid, last, grain, leaf, combine, false));
+    } else {
+        auto [left, right] =
+            co_await when_all(fork_join<T>(sched, first, mid, grain, leaf, combine, true),
+                              fork_join<T>(sched, mid, last, grain, leaf, combine, false));
+        co_return combine(std::move(left), std::move(right));
+    }
+}
+
+/// Number of elements processed between the checks of lazy binary splitting.
+template <lazy_splitting_scheduler S>
+std::size_t lazy_chunk(S &sched, std::size_t n) {
+    return std::clamp<std::size_t>(n / (64 * worker_count(sched)), 1, 4096);
+}
+
+/// Lazy binary splitting: applies @p leaf to `[first, last)` sequentially,
+/// @p chunk elements at a time, and only when @p sched reports that the
+/// current worker is starving (there is nothing left to steal from it) the
+/// rest of the range is split in halves like in @ref fork_join().
+/// The number of tasks thus adapts to the demand of the idle workers, without
+/// a grain size to tune.
+template <typename T, lazy_splitting_scheduler S, typename Leaf, typename Combine>
+task<T> lazy_fork_join(S &sched, std::size_t first, std::size_t last, std::size_t chunk,
+                       Leaf &leaf, Combine &combine, bool fork) {
+    TRACE_FUNC();
+    if (fork)
+        co_await sched.schedule();
+    if constexpr (std::is_void_v<T>) {
+        while (last - first > chunk && !sched.is_starving()) {
+            leaf(first, first + chunk);
+            first += chunk;
+        }
+        if (last - first <= chunk)
+            co_return leaf(first, last);
+        const std::size_t mid = first + (last - first) / 2;
+        co_await when_all(lazy_fork_join<T>(sched, mid, last, chunk, leaf, combine, true),
+                          lazy_fork_join<T>(sched, first, mid, chunk, leaf, combine, false));
+    } else {
+        std::optional<T> result; // of the elements processed so far
+        const auto accumulate = [&](T value) {
+            if (result)
+                result.emplace(combine(std::move(*result), std::move(value)));
+            else
+                result.emplace(std::move(value));
+        };
+        while (last - first > chunk && !sched.is_starving()) {
+            accumulate(leaf(first, first + chunk));
+            first += chunk;
+        }
+        if (last - first <= chunk) {
+            accumulate(leaf(first, last));
+        } else {
+            const std::size_t mid = first + (last - first) / 2;
+            auto [right, left] = co_await when_all(
+                lazy_fork_join<T>(sched, mid, last, chunk, leaf, combine, true),
+                lazy_fork_join<T>(sched, first, mid, chunk, leaf, combine, false));
+            accumulate(std::move(left));
+            accumulate(std::move(right));
+        }
+        co_return std::move(*result);
+    }
+}
+
+/// Applies @p leaf to all of `[0, n)`: with lazy binary splitting for
+/// @ref auto_grain if @p sched supports it, and with @ref fork_join()
+/// otherwise.
+/// @pre `n > 0` unless `T` is `void`.
+template <typename T, scheduler S, typename Leaf, typename Combine>
+task<T> split_range(S &sched, std::size_t n, std::size_t grain, Leaf &leaf, Combine &combine) {
+    if constexpr (lazy_splitting_scheduler<S>)
+        if (grain == auto_grain)
+            // started on a worker, so that the caller's thread doesn't split
+            return lazy_fork_join<T>(sched, 0, n, lazy_chunk(sched, n), leaf, combine, true);
+    return fork_join<T>(sched, 0, n, grain == auto_grain ? default_grain(sched, n) : grain, leaf,
+                        combine, false);
+}
+
+template <std::ranges::random_access_range V>
+auto iterator_at(V &view, std::size_t index) {
+    return std::ranges::begin(view) + static_cast<std::ranges::range_difference_t<V>>(index);
+}
+
+struct no_combine {};
+
+template <scheduler S, typename V, typename Fn>
+task<> parallel_for_each_impl(S &sched, V view, Fn fn, std::size_t grain) {
+    TRACE_FUNC();
+    const auto n = static_cast<std::size_t>(std::ranges::size(view));
+    auto leaf = [&](std::size_t first, std::size_t last) {
+        std::for_each(iterator_at(view, first), iterator_at(view, last), std::ref(fn));
+    };
+    no_combine combine;
+    co_await split_range<void>(sched, n, grain, leaf, combine);
+}
+
+template <scheduler S, typename V, typename O, typename Fn>
+task<O> parallel_transform_impl(S &sched, V view, O out, Fn fn, std::size_t grain) {
+    TRACE_FUNC();
+    const auto n = static_cast<std::size_t>(std::ranges::size(view));
+    auto leaf = [&](std::size_t first, std::size_t last) {
+        std::transform(iterator_at(view, first), iterator_at(view, last),
+                       out + static_cast<std::iter_difference_t<O>>(first), std::ref(fn));
+    };
+    no_combine combine;
+    co_await split_range<void>(sched, n, grain, leaf, combine);
+    co_return out + static_cast<std::iter_difference_t<O>>(n);
+}
+
+template <typename T, scheduler S, typename V, typename Reduce, typename Transform>
+task<T> parallel_transform_reduce_impl(S &sched, V view, T init, Reduce reduce,
+                                       Transform transform, std::size_t grain) {
+    TRACE_FUNC();
+    const auto n = static_cast<std::size_t>(std::ranges::size(view));
+    if (n == 0)
+        co_return init;
+    // every leaf is non-empty, so it starts its sum with its first element
+    auto leaf = [&](std::size_t first, std::size_t last) -> T {
+        return std::transform_reduce(iterator_at(view, first + 1), iterator_at(view, last),
+                                     T(std::invoke(transform, *iterator_at(view, first))),
+                                     std::ref(reduce), std::ref(transform));
+    };
+    auto combine = [&](T left, T right) -> T {
+        return std::invoke(reduce, std::move(left), std::move(right));
+    };
+    T sum = co_await split_range<T>(sched, n, grain, leaf, combine);
+    co_return std::invoke(reduce, std::move(init), std::move(sum));
+}
+
+} // namespace detail
+
+/// Invokes @p fn on every element of @p range, in parallel on the workers of
+/// @p sched.
+///
+/// The range is split recursively in halves (fork-join) down to sub-ranges of
+/// @p grain elements that are processed sequentially, the awaiting coroutine
+/// taking part in the work.
+///
+/// With @ref auto_grain, a @ref lazy_splitting_scheduler runs the whole range
+/// on one of its workers sequentially, and splits the rest of it in halves
+/// only when the worker is starving, i.e. when no work is left in its queue
+/// for the other workers to steal (Lazy Binary Splitting). Other schedulers
+/// get about 8 sub-ranges per worker.
+///
+/// The awaiting coroutine is resumed when all the work is done (possibly on
+/// another thread). If @p fn throws, the exception is
+/// rethrown to the awaiting coroutine after all the sub-ranges complete
+/// (sub-ranges not yet started still run).
+/// @note   Lvalue ranges are referenced, so they must outlive the returned
+///         @ref task; rvalue ones are moved into it.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> normalize(thread_pool &pool, std::vector<double> &v, double norm) {
+///     co_await parallel_for_each(pool, v, [=](double &x) { x /= norm; });
+/// }
+/// ```
+template <scheduler S, std::ranges::random_access_range R, typename Fn>
+    requires std::ranges::sized_range<R> &&
+             std::invocable<Fn &, std::ranges::range_reference_t<R>>
+[[nodiscard]] task<> parallel_for_each(S &sched, R &&range, Fn fn,
+                                       std::size_t grain = auto_grain) {
+    TRACE_FUNC();
+    return detail::parallel_for_each_impl(sched, std::views::all(std::forward<R>(range)),
+                                          std::move(fn), grain);
+}
+
+/// Stores `fn(x)` for every element `x` of @p range to the corresponding
+/// element of the range beginning at @p out, in parallel on the workers of
+/// @p sched (see @ref parallel_for_each()). Produces the iterator past the
+/// last element written.
+template <scheduler S, std::ranges::random_access_range R, std::random_access_iterator O,
+          typename Fn>
+    requires std::ranges::sized_range<R> &&
+             std::indirectly_writable<
+                 O, std::invoke_result_t<Fn &, std::ranges::range_reference_t<R>>>
+[[nodiscard]] task<O> parallel_transform(S &sched, R &&range, O out, Fn fn,
+                                         std::size_t grain = auto_grain) {
+    TRACE_FUNC();
+    return detail::parallel_transform_impl(sched, std::views::all(std::forward<R>(range)),
+                                           std::move(out), std::move(fn), grain);
+}
+
+/// Produces the reduction with @p reduce of @p init and `transform(x)` for
+/// all the elements `x` of @p range, computed in parallel on the workers of
+/// @p sched (see @ref parallel_for_each()).
+///
+/// As for `std::transform_reduce()`, @p reduce must be associative and
+/// commutative, as the grouping and the order of the operations is
+/// unspecified.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<double> norm(thread_pool &pool, const std::vector<double> &v) {
+///     co_return std::sqrt(co_await parallel_transform_reduce(pool, v, 0.0, std::plus<>(),
+///                                                            [](double x) { return x * x; }));
+/// }
+/// ```
+template <scheduler S, std::ranges::random_access_range R, std::move_constructible T,
+          typename Reduce, typename Transform>
+    requires std::ranges::sized_range<R> &&
+             std::invocable<Transform &, std::ranges::range_reference_t<R>> &&
+             std::invocable<Reduce &, T, T>
+[[nodiscard]] task<T> parallel_transform_reduce(S &sched, R &&range, T init, Reduce reduce,
+                                                Transform transform,
+                                                std::size_t grain = auto_grain) {
+    TRACE_FUNC();
+    return detail::parallel_transform_reduce_impl(sched,
+                                                  std::views::all(std::forward<R>(range)),
+                                                  std::move(init), std::move(reduce),
+                                                  std::move(transform), grain);
+}
+
+} // namespace mp_coro
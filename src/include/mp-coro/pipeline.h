@@ -0,0 +1,315 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bounded_channel.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/eager_task.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/when_all.h>
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Dataflow pipelines: stages connected by @ref mp_coro::bounded_channel
+/// "bounded channels", each stage running in its own coroutine.
+///
+/// A pipeline starts with @ref source(), goes through any number of @ref map(),
+/// @ref filter() and @ref parallel_map() stages, and ends with @ref sink(),
+/// which produces a @ref mp_coro::task that runs all the stages:
+///
+/// ```cpp
+/// task<> etl(thread_pool &pool) {
+///     co_await (pipeline::source(read_rows("input.csv"))
+///               | pipeline::parallel_map(pool, parse, 16)
+///               | pipeline::filter([](const record &r) { return r.valid; })
+///               | pipeline::sink([&](record r) { db.insert(std::move(r)); }));
+/// }
+/// ```
+///
+/// The memory used is bounded by the capacities of the channels. A stage that
+/// finishes closes both of its channels, so a failing stage stops the whole
+/// pipeline, and its exception is rethrown by the awaited @ref sink() task.
+namespace mp_coro::pipeline {
+
+/// Default capacity of the channel behind every stage.
+inline constexpr std::size_t default_capacity = 64;
+
+template <std::move_constructible T>
+class flow;
+
+namespace detail {
+
+template <typename... Channels>
+class close_on_exit {
+  public:
+    explicit close_on_exit(Channels &...channels) noexcept : channels_(channels...) {}
+    close_on_exit(const close_on_exit &) = delete;
+    close_on_exit &operator=(const close_on_exit &) = delete;
+    ~close_on_exit() {
+        std::apply([](auto &...channels) { (..., channels.close()); }, channels_);
+    }
+
+  private:
+    std::tuple<Channels &...> channels_;
+};
+
+template <typename T>
+using channel_ptr = std::shared_ptr<bounded_channel<T>>;
+
+template <typename R, typename T>
+task<> source_stage(R range, channel_ptr<T> out) {
+    TRACE_FUNC();
+    close_on_exit closer(*out);
+    for (auto &&value : range)
+        if (!co_await out->push(T(std::forward<decltype(value)>(value))))
+            break;
+}
+
+template <typename F, typename T, typename U>
+task<> map_stage(F fn, channel_ptr<T> in, channel_ptr<U> out) {
+    TRACE_FUNC();
+    close_on_exit closer(*in, *out);
+    while (std::optional<T> value = co_await in->pop())
+        if (!co_await out->push(std::invoke(fn, std::move(*value))))
+            break;
+}
+
+template <typename P, typename T>
+task<> filter_stage(P pred, channel_ptr<T> in, channel_ptr<T> out) {
+    TRACE_FUNC();
+    close_on_exit closer(*in, *out);
+    while (std::optional<T> value = co_await in->pop())
+        if (std::invoke(pred, std::as_const(*value)))
+            if (!co_await out->push(std::move(*value)))
+                break;
+}
+
+template <typename U, scheduler S, typename F, typename T>
+eager_task<U> parallel_map_job(S &sched, F &fn, T value) {
+    TRACE_FUNC();
+    co_await sched.schedule();
+    co_return std::invoke(fn, std::move(value));
+}
+
+/// Keeps up to @p concurrency invocations of @p fn running on @p sched. The
+/// queue of the running jobs in the input order is the reorder buffer: the
+/// results are emitted from its front only.
+template <scheduler S, typename F, typename T, typename U>
+task<> parallel_map_stage(S &sched, F fn, std::size_t concurrency, channel_ptr<T> in,
+                          channel_ptr<U> out) {
+    TRACE_FUNC();
+    std::deque<eager_task<U>> running;
+    std::exception_ptr error;
+    {
+        close_on_exit closer(*in, *out);
+        try {
+            bool input_open = true;
+            while (true) {
+                // emit the completed results first, but don't wait for them
+                // while more input can be started
+                if (input_open && running.size() < concurrency &&
+                    (running.empty() || !running.front().is_ready())) {
+                    if (std::optional<T> value = co_await in->pop())
+                        running.push_back(parallel_map_job<U>(sched, fn, std::move(*value)));
+                    else
+                        input_open = false;
+                    continue;
+                }
+                if (running.empty())
+                    break;
+                U result = co_await std::move(running.front());
+                running.pop_front();
+                if (!co_await out->push(std::move(result)))
+                    break;
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+    // the jobs still running reference `fn`
+    for (auto &job : running)
+        try {
+            (void)co_await job;
+        } catch (...) {
+        }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+template <typename F, typename T>
+task<> sink_stage(F fn, channel_ptr<T> in) {
+    TRACE_FUNC();
+    close_on_exit closer(*in);
+    while (std::optional<T> value = co_await in->pop()) {
+        if constexpr (awaitable<std::invoke_result_t<F &, T>>)
+            co_await std::invoke(fn, std::move(*value));
+        else
+            std::invoke(fn, std::move(*value));
+    }
+}
+
+inline task<> run_stages(std::vector<task<>> stages) {
+    TRACE_FUNC();
+    co_await when_all(stages);
+}
+
+template <typename F>
+struct map_adaptor {
+    F fn;
+    std::size_t capacity;
+};
+
+template <typename P>
+struct filter_adaptor {
+    P pred;
+    std::size_t capacity;
+};
+
+template <scheduler S, typename F>
+struct parallel_map_adaptor {
+    S &sched;
+    F fn;
+    std::size_t concurrency;
+    std::size_t capacity;
+};
+
+template <typename F>
+struct sink_adaptor {
+    F fn;
+};
+
+} // namespace detail
+
+/// Stream of values of type `T` produced by the stages of a pipeline built so
+/// far. Nothing runs until the pipeline is completed with @ref sink() and
+/// awaited.
+template <std::move_constructible T>
+class [[nodiscard]] flow {
+  public:
+    using value_type = T;
+
+    flow(detail::channel_ptr<T> out, std::vector<task<>> stages)
+        : out_(std::move(out)), stages_(std::move(stages)) {}
+
+    template <typename F>
+        requires std::invocable<F &, T> && std::move_constructible<std::invoke_result_t<F &, T>>
+    friend auto operator|(flow in, detail::map_adaptor<F> stage) {
+        using U = std::invoke_result_t<F &, T>;
+        auto out = std::make_shared<bounded_channel<U>>(stage.capacity);
+        return in.then(detail::map_stage(std::move(stage.fn), in.out_, out), out);
+    }
+
+    template <typename P>
+        requires std::predicate<P &, const T &>
+    friend flow operator|(flow in, detail::filter_adaptor<P> stage) {
+        auto out = std::make_shared<bounded_channel<T>>(stage.capacity);
+        return in.then(detail::filter_stage(std::move(stage.pred), in.out_, out), out);
+    }
+
+    template <scheduler S, typename F>
+        requires std::invocable<F &, T> && std::move_constructible<std::invoke_result_t<F &, T>>
+    friend auto operator|(flow in, detail::parallel_map_adaptor<S, F> stage) {
+        using U = std::invoke_result_t<F &, T>;
+        auto out = std::make_shared<bounded_channel<U>>(stage.capacity);
+        return in.then(detail::parallel_map_stage(stage.sched, std::move(stage.fn),
+                                                  stage.concurrency, in.out_, out),
+                       out);
+    }
+
+    template <typename F>
+        requires std::invocable<F &, T>
+    friend task<> operator|(flow in, detail::sink_adaptor<F> stage) {
+        in.stages_.push_back(detail::sink_stage(std::move(stage.fn), std::move(in.out_)));
+        return detail::run_stages(std::move(in.stages_));
+    }
+
+  private:
+    template <typename U>
+    flow<U> then(task<> stage, detail::channel_ptr<U> out) {
+        stages_.push_back(std::move(stage));
+        return flow<U>(std::move(out), std::move(stages_));
+    }
+
+    detail::channel_ptr<T> out_; // the output of the last stage
+    std::vector<task<>> stages_;
+};
+
+/// Starts a pipeline with the elements of @p range (e.g. a @ref generator),
+/// which is moved into the pipeline.
+template <std::ranges::input_range R>
+    requires std::move_constructible<std::ranges::range_value_t<R>>
+flow<std::ranges::range_value_t<R>> source(R range, std::size_t capacity = default_capacity) {
+    using T = std::ranges::range_value_t<R>;
+    auto out = std::make_shared<bounded_channel<T>>(capacity);
+    std::vector<task<>> stages;
+    stages.push_back(detail::source_stage(std::move(range), out));
+    return flow<T>(std::move(out), std::move(stages));
+}
+
+/// Stage that transforms every value with @p fn.
+template <typename F>
+[[nodiscard]] detail::map_adaptor<F> map(F fn, std::size_t capacity = default_capacity) {
+    return {std::move(fn), capacity};
+}
+
+/// Stage that passes on only the values that satisfy @p pred.
+template <typename P>
+[[nodiscard]] detail::filter_adaptor<P> filter(P pred, std::size_t capacity = default_capacity) {
+    return {std::move(pred), capacity};
+}
+
+/// Stage that transforms the values with up to @p concurrency invocations of
+/// @p fn running at the same time on @p sched, and emits the results in the
+/// order of the input values.
+///
+/// The results that complete out of order wait in a reorder buffer of at
+/// most @p concurrency entries, so the memory used stays bounded.
+template <scheduler S, typename F>
+[[nodiscard]] detail::parallel_map_adaptor<S, F> parallel_map(S &sched, F fn,
+                                                              std::size_t concurrency,
+                                                              std::size_t capacity =
+                                                                  default_capacity) {
+    return {sched, std::move(fn), std::max<std::size_t>(concurrency, 1), capacity};
+}
+
+/// Final stage that consumes every value with @p fn (which may return an
+/// awaitable to be awaited before the next value). Completes the pipeline
+/// into a @ref task that runs all its stages.
+template <typename F>
+[[nodiscard]] detail::sink_adaptor<F> sink(F fn) {
+    return {std::move(fn)};
+}
+
+} // namespace mp_coro::pipeline
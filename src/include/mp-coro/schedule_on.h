@@ -0,0 +1,203 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/get_awaiter.h>
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/bits/storage.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/type_traits.h>
+#include <concepts>
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+namespace mp_coro {
+
+namespace detail {
+
+/// Awaiters that use Symmetric Control Transfer: `await_suspend()` returns
+/// the coroutine to resume next (e.g. the awaited @ref task).
+template <typename A>
+concept symmetric_awaitable = awaitable<A> && requires(awaiter_for_t<A> a,
+                                                       std::coroutine_handle<> h) {
+    { a.await_suspend(h) } -> std::same_as<std::coroutine_handle<>>;
+};
+
+/// Suspends on the awaiter of `sched.schedule()` on behalf of @p handle
+/// (which is not necessarily the awaiting coroutine), adapting all kinds of
+/// `await_suspend()` return types to Symmetric Control Transfer.
+template <typename Awaiter>
+std::coroutine_handle<> schedule_handle(Awaiter &awaiter, std::coroutine_handle<> handle) {
+    if (awaiter.await_ready())
+        return handle;
+    using result_t = decltype(awaiter.await_suspend(handle));
+    if constexpr (std::is_void_v<result_t>) {
+        awaiter.await_suspend(handle);
+        return std::noop_coroutine();
+    } else if constexpr (std::same_as<result_t, bool>) {
+        return awaiter.await_suspend(handle) ? std::noop_coroutine() : handle;
+    } else {
+        return awaiter.await_suspend(handle);
+    }
+}
+
+template <scheduler S, symmetric_awaitable A>
+class schedule_on_awaitable {
+  public:
+    template <typename U>
+    schedule_on_awaitable(S &sched, U &&awaitable)
+        : sched_(sched), awaitable_(std::forward<U>(awaitable)) {}
+
+    decltype(auto) operator co_await() && {
+        using inner_t = std::remove_cvref_t<awaiter_for_t<A>>;
+        using sched_t =
+            std::remove_cvref_t<awaiter_for_t<decltype(std::declval<S &>().schedule())>>;
+        struct awaiter {
+            inner_t inner;
+            sched_t sched;
+
+            static bool await_ready() noexcept {
+                TRACE_FUNC();
+                return false;
+            }
+
+            /// Instead of resuming the coroutine returned by the inner
+            /// awaiter (e.g. the awaited @ref task) directly, schedules it on
+            /// the scheduler. Its completion resumes the awaiting coroutine as
+            /// usual (on the scheduler's thread).
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) {
+                TRACE_FUNC();
+                std::coroutine_handle<> next = handle;
+                if (!inner.await_ready()) {
+                    // the coroutine must be returned, not yielded to the queue
+                    // of the current worker
+                    resumption_budget::scope no_preemption(nullptr);
+                    next = inner.await_suspend(handle);
+                }
+                return schedule_handle(sched, next);
+            }
+
+            decltype(auto) await_resume() {
+                TRACE_FUNC();
+                return inner.await_resume();
+            }
+        };
+        return awaiter {detail::get_awaiter(std::forward<A>(awaitable_)),
+                        detail::get_awaiter(sched_.schedule())};
+    }
+
+  private:
+    S &sched_;
+    A awaitable_; // a reference for lvalues, owned for rvalues
+};
+
+template <scheduler S>
+class resume_on_adaptor;
+
+} // namespace detail
+
+/// Returns an awaitable that starts @p awaitable on a thread of @p sched. The
+/// awaiting coroutine is then resumed on the thread on which the
+/// @p awaitable completes.
+///
+/// For awaitables that use Symmetric Control Transfer (like @ref task) no
+/// coroutine frame is allocated: the coroutine that would be resumed by the
+/// awaiter (the task) is scheduled on @p sched instead. Other awaitables are
+/// wrapped in a @ref task first.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> handle(io_context &io, thread_pool &compute) {
+///     auto data = co_await read(io);
+///     auto result = co_await schedule_on(compute, crunch(data)); // on compute
+///     co_await resume_on(io);                                    // back on io
+///     co_await write(io, result);
+/// }
+/// ```
+template <scheduler S, awaitable A>
+[[nodiscard]] awaitable auto schedule_on(S &sched, A &&awaitable) {
+    TRACE_FUNC();
+    if constexpr (detail::symmetric_awaitable<A>)
+        return detail::schedule_on_awaitable<S, A>(sched, std::forward<A>(awaitable));
+    else
+        return detail::schedule_on_awaitable<S, task<remove_rvalue_reference_t<await_result_t<A>>>>(
+            sched, make_task(std::forward<A>(awaitable)));
+}
+
+/// Awaits @p awaitable and then resumes the awaiting coroutine on a thread of
+/// @p sched, also if @p awaitable throws. Uses a @ref task frame to get
+/// control back after @p awaitable completes.
+template <scheduler S, awaitable A>
+[[nodiscard]] task<remove_rvalue_reference_t<await_result_t<A>>> resume_on(S &sched,
+                                                                           A &&awaitable) {
+    TRACE_FUNC();
+    detail::storage<remove_rvalue_reference_t<await_result_t<A>>> result;
+    try {
+        if constexpr (std::is_void_v<await_result_t<A>>)
+            co_await std::forward<A>(awaitable);
+        else
+            result.set_value(co_await std::forward<A>(awaitable));
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+    co_await sched.schedule();
+    co_return std::move(result).get();
+}
+
+/// Returns an adaptor that, when awaited, resumes the awaiting coroutine on a
+/// thread of @p sched (equivalent to `co_await sched.schedule()`), and that
+/// can be piped into from an awaitable: `co_await (a | resume_on(sched))` is
+/// `co_await resume_on(sched, a)`.
+template <scheduler S>
+[[nodiscard]] detail::resume_on_adaptor<S> resume_on(S &sched) noexcept {
+    return detail::resume_on_adaptor<S>(sched);
+}
+
+namespace detail {
+
+template <scheduler S>
+class resume_on_adaptor {
+  public:
+    explicit resume_on_adaptor(S &sched) noexcept : sched_(sched) {}
+
+    auto operator co_await() const {
+        using sched_t = std::remove_cvref_t<awaiter_for_t<decltype(sched_.schedule())>>;
+        return sched_t(detail::get_awaiter(sched_.schedule()));
+    }
+
+    template <awaitable A>
+    friend auto operator|(A &&awaitable, resume_on_adaptor adaptor) {
+        return mp_coro::resume_on(adaptor.sched_, std::forward<A>(awaitable));
+    }
+
+  private:
+    S &sched_;
+};
+
+} // namespace detail
+
+} // namespace mp_coro
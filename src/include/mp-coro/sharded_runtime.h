@@ -0,0 +1,518 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/bits/storage.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/numa.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/type_traits.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace mp_coro {
+
+namespace detail {
+
+/// Result type of @ref sharded_runtime::submit_to(): the result of @p F, or
+/// the result of awaiting it if it returns an awaitable.
+template <typename F>
+struct submit_result {
+    using type = std::invoke_result_t<F>;
+};
+
+template <typename F>
+    requires awaitable<std::invoke_result_t<F>>
+struct submit_result<F> {
+    using type = remove_rvalue_reference_t<await_result_t<std::invoke_result_t<F>>>;
+};
+
+template <typename F>
+using submit_result_t = typename submit_result<F>::type;
+
+} // namespace detail
+
+/// Share-nothing runtime: one event loop per shard, each running on its own
+/// thread pinned to its own core.
+///
+/// The state of a shard is owned by its thread: the ready queue and the
+/// timers are plain intrusive data structures that are never accessed
+/// concurrently, so scheduling work on the current shard, sleeping, and
+/// switching between coroutines do not touch any shared atomic. Work is
+/// moved between shards through single-producer single-consumer mailboxes
+/// (one for every pair of shards), and threads that do not belong to the
+/// runtime post to a mutex-protected inbox of the shard. Throughput scales
+/// with the number of cores as long as the shards mostly work on their own
+/// data.
+///
+/// The coroutines resumed by a shard get a resumption budget (see
+/// @ref yield()), so a busy coroutine can't starve the others on its shard.
+///
+/// @pre    All the work scheduled on the runtime (including the coroutines
+///         sleeping on its timers) must be complete when it is destroyed.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> put(sharded_runtime &rt, std::string key, std::string value) {
+///     const std::size_t owner = std::hash<std::string>{}(key) % rt.shard_count();
+///     co_await rt.submit_to(owner, [&] { maps[owner][key] = value; }); // no locks
+/// }
+/// ```
+class sharded_runtime : private detail::noncopyable {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /// Returned by @ref this_shard() on threads that do not belong to the
+    /// runtime.
+    static constexpr std::size_t no_shard = std::numeric_limits<std::size_t>::max();
+
+    /// Awaiter returned by @ref schedule(). Also serves as the node of the
+    /// intrusive queues.
+    class schedule_operation {
+      public:
+        schedule_operation(sharded_runtime &rt, std::size_t shard) noexcept
+            : runtime_(rt), shard_(shard) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Enqueues the awaiting coroutine on the target shard.
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            TRACE_FUNC();
+            item_.handle = handle;
+            runtime_.post(shard_, item_);
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        sharded_runtime &runtime_;
+        std::size_t shard_;
+        detail::work_item item_;
+    };
+
+    /// Awaiter returned by @ref sleep_until() and @ref sleep_for().
+    class sleep_operation {
+      public:
+        sleep_operation(sharded_runtime &rt, clock::time_point deadline) noexcept
+            : runtime_(rt), deadline_(deadline) {}
+
+        bool await_ready() const noexcept {
+            TRACE_FUNC();
+            return deadline_ <= clock::now();
+        }
+
+        /// Adds a timer to the current shard.
+        void await_suspend(std::coroutine_handle<> handle) {
+            TRACE_FUNC();
+            assert(runtime_.this_shard() != no_shard && "sleeping outside of the runtime");
+            item_.handle = handle;
+            current_->add_timer(deadline_, item_);
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        sharded_runtime &runtime_;
+        clock::time_point deadline_;
+        detail::work_item item_;
+    };
+
+    /// Starts @p shard_count shards (at least one).
+    /// @param  pin_threads  Pins the thread of the n-th shard to the n-th CPU
+    ///                      the process is allowed to run on (Linux only),
+    ///                      and binds it to the NUMA node of that CPU.
+    explicit sharded_runtime(std::size_t shard_count = std::thread::hardware_concurrency(),
+                             bool pin_threads = true) {
+        shard_count = std::max<std::size_t>(shard_count, 1);
+        shards_.reserve(shard_count);
+        for (std::size_t i = 0; i < shard_count; ++i)
+            shards_.push_back(std::make_unique<shard_state>(*this, i, shard_count));
+        std::vector<worker_affinity> affinities(shard_count);
+        if (pin_threads) {
+            const auto topology = numa_topology::discover();
+            const auto cpus = detail::allowed_cpus();
+            for (std::size_t i = 0; i < shard_count; ++i) {
+                const unsigned cpu = cpus[i % cpus.size()];
+                affinities[i] = {topology.node_of(cpu), {cpu}};
+            }
+        }
+        threads_.reserve(shard_count);
+        for (std::size_t i = 0; i < shard_count; ++i)
+            threads_.emplace_back([this, i, affinity = affinities[i]](std::stop_token stop) {
+                run(*shards_[i], affinity, stop);
+            });
+    }
+
+    /// Stops the shards once they run out of work and joins their threads.
+    ~sharded_runtime() {
+        for (auto &t : threads_)
+            t.request_stop();
+        threads_.clear();
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on @p shard.
+    [[nodiscard]] schedule_operation schedule(std::size_t shard) noexcept {
+        assert(shard < shards_.size() && "unknown shard");
+        return schedule_operation {*this, shard};
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on the current
+    /// shard at @p deadline.
+    /// @pre    Awaited on one of the shards.
+    [[nodiscard]] sleep_operation sleep_until(clock::time_point deadline) noexcept {
+        return sleep_operation {*this, deadline};
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on the current
+    /// shard after @p duration.
+    /// @pre    Awaited on one of the shards.
+    template <typename Rep, typename Period>
+    [[nodiscard]] sleep_operation
+    sleep_for(std::chrono::duration<Rep, Period> duration) noexcept {
+        return sleep_until(clock::now() + std::chrono::ceil<clock::duration>(duration));
+    }
+
+    /// Invokes @p fn on @p shard (and awaits its result if it returns an
+    /// awaitable), and then resumes the awaiting coroutine back on the shard it
+    /// was running on (if any), also if @p fn throws.
+    template <std::invocable F>
+    [[nodiscard]] task<detail::submit_result_t<F>> submit_to(std::size_t shard, F fn) {
+        TRACE_FUNC();
+        const std::size_t home = this_shard();
+        co_await schedule(shard);
+        detail::storage<detail::submit_result_t<F>> result;
+        try {
+            if constexpr (awaitable<std::invoke_result_t<F>>) {
+                if constexpr (std::is_void_v<detail::submit_result_t<F>>)
+                    co_await std::invoke(fn);
+                else
+                    result.set_value(co_await std::invoke(fn));
+            } else if constexpr (std::is_void_v<detail::submit_result_t<F>>) {
+                std::invoke(fn);
+            } else {
+                result.set_value(std::invoke(fn));
+            }
+        } catch (...) {
+            result.set_exception(std::current_exception());
+        }
+        if (home != no_shard && home != this_shard())
+            co_await schedule(home);
+        co_return std::move(result).get();
+    }
+
+    /// Index of the shard running on the current thread, or @ref no_shard.
+    [[nodiscard]] std::size_t this_shard() const noexcept {
+        return current_ && &current_->runtime == this ? current_->index : no_shard;
+    }
+
+    /// Number of shards.
+    [[nodiscard]] std::size_t shard_count() const noexcept { return shards_.size(); }
+
+  private:
+    /// Intrusive FIFO of work items.
+    struct work_list {
+        detail::work_item *head = nullptr;
+        detail::work_item *tail = nullptr;
+
+        [[nodiscard]] bool empty() const noexcept { return head == nullptr; }
+
+        void push(detail::work_item *item) noexcept {
+            item->next = nullptr;
+            if (tail)
+                tail->next = item;
+            else
+                head = item;
+            tail = item;
+        }
+
+        detail::work_item *pop() noexcept {
+            detail::work_item *item = head;
+            head = item->next;
+            if (!head)
+                tail = nullptr;
+            return item;
+        }
+
+        void splice(work_list &other) noexcept {
+            if (other.empty())
+                return;
+            if (tail)
+                tail->next = other.head;
+            else
+                head = other.head;
+            tail = std::exchange(other.tail, nullptr);
+            other.head = nullptr;
+        }
+    };
+
+    /// Bounded single-producer single-consumer ring of work items from one
+    /// shard to another. Each side caches the index of the other one, so the
+    /// shared cache lines are only read when the ring looks full or empty.
+    class mailbox {
+      public:
+        /// Called by the producer shard only.
+        /// @retval false if the ring is full.
+        bool try_push(detail::work_item *item) noexcept {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_cache_ == capacity) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if (tail - head_cache_ == capacity)
+                    return false;
+            }
+            slots_[tail % capacity] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Called by the consumer shard only.
+        detail::work_item *try_pop() noexcept {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_cache_) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (head == tail_cache_)
+                    return nullptr;
+            }
+            detail::work_item *item = slots_[head % capacity];
+            head_.store(head + 1, std::memory_order_release);
+            return item;
+        }
+
+        /// Called by the consumer shard only.
+        [[nodiscard]] bool empty() const noexcept {
+            return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+        }
+
+      private:
+        static constexpr std::size_t capacity = 256;
+        alignas(64) std::atomic<std::size_t> head_ = 0; // written by the consumer
+        std::size_t tail_cache_ = 0;                    // consumer's copy of tail_
+        alignas(64) std::atomic<std::size_t> tail_ = 0; // written by the producer
+        std::size_t head_cache_ = 0;                    // producer's copy of head_
+        alignas(64) std::array<detail::work_item *, capacity> slots_ {};
+    };
+
+    struct timer {
+        clock::time_point deadline;
+        detail::work_item *item;
+    };
+
+    /// State of a shard. Unless stated otherwise, only accessed by its
+    /// thread.
+    struct shard_state final : detail::resumption_budget {
+        static constexpr std::size_t budget = 64;
+
+        shard_state(sharded_runtime &rt, std::size_t i, std::size_t shard_count)
+            : resumption_budget(budget),
+              runtime(rt),
+              index(i),
+              inbox(std::make_unique<mailbox[]>(shard_count)),
+              overflow(shard_count) {}
+
+        void yield(detail::work_item &item) noexcept override {
+            refill();
+            ready.push(&item);
+        }
+
+        void add_timer(clock::time_point deadline, detail::work_item &item) {
+            timers.push_back({deadline, &item});
+            std::ranges::push_heap(timers, std::ranges::greater {}, &timer::deadline);
+        }
+
+        sharded_runtime &runtime;
+        const std::size_t index;
+        work_list ready;
+        std::vector<timer> timers; // min-heap
+        /// Indexed by the source shard: only this shard pops, only the source
+        /// pushes.
+        std::unique_ptr<mailbox[]> inbox;
+        /// Indexed by the target shard: items that did not fit in its mailbox
+        /// yet.
+        std::vector<work_list> overflow;
+        std::size_t overflow_count = 0;
+
+        // work posted by threads that do not belong to the runtime
+        std::mutex external_mutex;
+        work_list external; // guarded by external_mutex
+        std::atomic<bool> has_external = false;
+
+        // parking (accessed by any thread)
+        std::atomic<bool> sleeping = false;
+        std::mutex sleep_mutex;
+        std::condition_variable_any sleep_cv;
+        bool notified = false; // guarded by sleep_mutex
+    };
+
+    void post(std::size_t target, detail::work_item &item) {
+        shard_state &to = *shards_[target];
+        shard_state *from = current_;
+        if (from == &to) {
+            to.ready.push(&item); // the fast path: no atomics
+            return;
+        }
+        if (from && &from->runtime == this) {
+            work_list &overflow = from->overflow[target];
+            // keep the FIFO order behind the items that did not fit before
+            if (!overflow.empty() || !to.inbox[from->index].try_push(&item)) {
+                overflow.push(&item);
+                ++from->overflow_count;
+                return;
+            }
+        } else {
+            std::lock_guard lock(to.external_mutex);
+            to.external.push(&item);
+            to.has_external.store(true, std::memory_order_release);
+        }
+        wake(to);
+    }
+
+    /// Pairs with the fence in @ref run() before a shard goes to sleep: either
+    /// the producer sees the shard sleeping, or the shard sees the new item.
+    static void wake(shard_state &s) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s.sleeping.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard lock(s.sleep_mutex);
+                s.notified = true;
+            }
+            s.sleep_cv.notify_one();
+        }
+    }
+
+    bool has_incoming(shard_state &s) const noexcept {
+        if (s.has_external.load(std::memory_order_acquire))
+            return true;
+        for (std::size_t i = 0; i < shards_.size(); ++i)
+            if (!s.inbox[i].empty())
+                return true;
+        return false;
+    }
+
+    void poll(shard_state &s) {
+        for (std::size_t i = 0; i < shards_.size(); ++i)
+            while (auto *item = s.inbox[i].try_pop())
+                s.ready.push(item);
+        if (s.has_external.load(std::memory_order_acquire)) {
+            std::lock_guard lock(s.external_mutex);
+            s.ready.splice(s.external);
+            s.has_external.store(false, std::memory_order_relaxed);
+        }
+        if (s.overflow_count != 0)
+            for (std::size_t target = 0; target < shards_.size(); ++target) {
+                work_list &overflow = s.overflow[target];
+                bool pushed = false;
+                mailbox &box = shards_[target]->inbox[s.index];
+                while (!overflow.empty() && box.try_push(overflow.head)) {
+                    overflow.pop();
+                    --s.overflow_count;
+                    pushed = true;
+                }
+                if (pushed)
+                    wake(*shards_[target]);
+            }
+        if (!s.timers.empty()) {
+            const auto now = clock::now();
+            while (!s.timers.empty() && s.timers.front().deadline <= now) {
+                std::ranges::pop_heap(s.timers, std::ranges::greater {}, &timer::deadline);
+                s.ready.push(s.timers.back().item);
+                s.timers.pop_back();
+            }
+        }
+    }
+
+    /// Parks the shard until new work arrives or its next timer expires.
+    void park(shard_state &s, const std::stop_token &stop) {
+        s.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!has_incoming(s)) {
+            std::unique_lock lock(s.sleep_mutex);
+            const auto woken = [&] { return s.notified; };
+            if (stop.stop_requested()) {
+                // only timers or incoming work left: do not spin on the stop token
+                if (s.timers.empty())
+                    s.sleep_cv.wait(lock, woken);
+                else
+                    s.sleep_cv.wait_until(lock, s.timers.front().deadline, woken);
+            } else if (s.timers.empty())
+                s.sleep_cv.wait(lock, stop, woken);
+            else
+                s.sleep_cv.wait_until(lock, stop, s.timers.front().deadline, woken);
+            s.notified = false;
+        }
+        s.sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    void run(shard_state &s, const worker_affinity &affinity, std::stop_token stop) {
+        detail::bind_current_thread(affinity);
+        current_ = &s;
+        detail::resumption_budget::scope budget_scope(&s);
+        while (true) {
+            poll(s);
+            if (!s.ready.empty()) {
+                // a batch at a time, so that the mailboxes are polled regularly
+                for (std::size_t n = 0; n < shard_state::budget && !s.ready.empty(); ++n) {
+                    s.refill();
+                    s.ready.pop()->handle.resume();
+                }
+                continue;
+            }
+            if (s.overflow_count != 0) {
+                std::this_thread::yield(); // a target's mailbox is full
+                continue;
+            }
+            if (stop.stop_requested() && s.timers.empty() && !has_incoming(s))
+                break;
+            park(s, stop);
+        }
+        current_ = nullptr;
+    }
+
+    static inline thread_local shard_state *current_ = nullptr;
+    std::vector<std::unique_ptr<shard_state>> shards_;
+    std::vector<std::jthread> threads_; // must be the last member (joined first)
+};
+
+} // namespace mp_coro
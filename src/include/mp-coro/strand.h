@@ -0,0 +1,213 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/trace.h>
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+namespace mp_coro {
+
+namespace detail {
+
+/// Coroutine that drains a @ref strand on its scheduler once the thread that
+/// started draining it inline runs out of budget.
+struct strand_drainer {
+    struct promise_type {
+        strand_drainer get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        static std::suspend_always initial_suspend() noexcept { return {}; }
+        static std::suspend_always final_suspend() noexcept { return {}; }
+        static void return_void() noexcept {}
+        static void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+} // namespace detail
+
+/// Serial executor on top of another (possibly multi-threaded) scheduler:
+/// coroutines resumed through `co_await strand.schedule()` never run
+/// concurrently with each other, so the state owned by the @ref strand can be
+/// accessed without locks (actor-style).
+///
+/// A coroutine runs on the @ref strand from its resumption until its next
+/// suspension point (e.g. `co_await pool.schedule()` leaves the @ref strand).
+///
+/// Awaiting coroutines are pushed to an intrusive lock-free MPSC queue (the
+/// nodes are the awaiters returned by @ref schedule()), and counted in an
+/// atomic counter. The thread that increments the counter from zero becomes
+/// the owner of the @ref strand and resumes the queued coroutines inline, up
+/// to `budget` of them. If there is still work left after that, draining
+/// continues on a thread of the underlying scheduler, so one thread can't be
+/// captured by a busy @ref strand.
+///
+/// @pre    The @ref strand must be idle when destroyed. Note that the thread
+///         draining it still accesses it after the last coroutine it resumed
+///         suspends, so the coroutines running on the @ref strand must not
+///         destroy it (e.g. keep it alive until the underlying scheduler is
+///         stopped).
+///
+/// @par Example
+///
+/// ```cpp
+/// class account {
+///     strand<thread_pool> strand_;
+///     long balance_ = 0; // only accessed on strand_
+///   public:
+///     task<> deposit(long amount) {
+///         co_await strand_.schedule();
+///         balance_ += amount;
+///     }
+/// };
+/// ```
+template <scheduler S>
+class strand : private detail::noncopyable {
+  public:
+    /// Awaiter returned by @ref schedule(). Also serves as the node of the
+    /// intrusive queue.
+    class schedule_operation {
+      public:
+        explicit schedule_operation(strand &s) noexcept : strand_(s) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Enqueues the awaiting coroutine. If the @ref strand was idle, drains
+        /// it on the current thread, which resumes the awaiting coroutine
+        /// before this function returns.
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            TRACE_FUNC();
+            handle_ = handle;
+            strand &s = strand_; // `*this` may be gone once pushed
+            s.push(this);
+            if (s.count_.fetch_add(1, std::memory_order_acq_rel) == 0 && !s.drain())
+                s.drainer_.handle.resume();
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        friend strand;
+        strand &strand_;
+        std::coroutine_handle<> handle_;
+        schedule_operation *next_ = nullptr;
+    };
+
+    /// @param  sched   Scheduler used when the @ref strand has to be drained
+    ///                 asynchronously.
+    /// @param  budget  Maximum number of coroutines resumed by a thread in a
+    ///                 row before draining continues on @p sched.
+    explicit strand(S &sched, std::size_t budget = 64)
+        : sched_(sched), budget_(budget ? budget : 1), drainer_(drain_loop(*this)) {}
+
+    ~strand() {
+        assert(count_.load(std::memory_order_relaxed) == 0 && "strand destroyed while busy");
+        drainer_.handle.destroy();
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on the
+    /// @ref strand.
+    [[nodiscard]] schedule_operation schedule() noexcept { return schedule_operation {*this}; }
+
+  private:
+    void push(schedule_operation *op) noexcept {
+        op->next_ = incoming_.load(std::memory_order_relaxed);
+        while (!incoming_.compare_exchange_weak(op->next_, op, std::memory_order_release,
+                                                std::memory_order_relaxed)) {}
+    }
+
+    /// Only called by the owner of the @ref strand. There is always something
+    /// to pop when the counter says so.
+    schedule_operation *pop() noexcept {
+        if (!ready_) {
+            // take everything pushed so far and reverse it to FIFO order
+            auto *op = incoming_.exchange(nullptr, std::memory_order_acquire);
+            while (op) {
+                auto *next = op->next_;
+                op->next_ = ready_;
+                ready_ = std::exchange(op, next);
+            }
+        }
+        return std::exchange(ready_, ready_->next_);
+    }
+
+    /// Resumes up to @ref budget_ coroutines. The resumption budget of the
+    /// worker is disabled meanwhile, as a preempted coroutine would continue
+    /// outside of the @ref strand.
+    /// @param  release Whether to release the @ref strand when no work is
+    ///                 left; otherwise its last count is left to the caller.
+    /// @retval true if the @ref strand became idle.
+    bool drain(bool release = true) noexcept {
+        detail::resumption_budget::scope no_preemption(nullptr);
+        for (std::size_t n = 0; n < budget_; ++n) {
+            pop()->handle_.resume();
+            // only the owner decrements the counter, so it can't drop to 1 meanwhile
+            if (!release && count_.load(std::memory_order_acquire) == 1)
+                return true;
+            if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                return true;
+        }
+        return false;
+    }
+
+    /// Releases the last count of an idle @ref strand once the drainer is
+    /// suspended, so that the next owner can't resume it while it still runs.
+    /// Does not suspend if new work arrived meanwhile.
+    struct release_operation {
+        strand &s;
+
+        static bool await_ready() noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<>) const noexcept {
+            return s.count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+        static void await_resume() noexcept {}
+    };
+
+    static detail::strand_drainer drain_loop(strand &s) {
+        while (true) {
+            co_await s.sched_.schedule();
+            if (s.drain(false))
+                co_await release_operation {s}; // until the next time the budget runs out
+        }
+    }
+
+    S &sched_;
+    const std::size_t budget_;
+    std::atomic<schedule_operation *> incoming_ = nullptr; // LIFO pushed by any thread
+    schedule_operation *ready_ = nullptr;                  // FIFO owned by the drainer
+    std::atomic<std::size_t> count_ = 0;
+    detail::strand_drainer drainer_;
+};
+
+} // namespace mp_coro
@@ -25,6 +25,7 @@
 #include <mp-coro/bits/synchronized_task.h>
 #include <mp-coro/concepts.h>
 #include <mp-coro/trace.h>
+#include <mp-coro/type_traits.h>
 #include <semaphore>
 
 namespace mp_coro {
@@ -32,8 +33,10 @@ namespace mp_coro {
 /// Creates a [synchronized task](@ref detail::make_synchronized_task) from the
 /// awaitable, starts it, and waits for it to complete, returning the result.
 /// Uses a `std::binary_semaphore` for waiting and synchronization.
+/// Values are returned by value (moved out of the task before it is
+/// destroyed), references are returned as is.
 template <awaitable A>
-[[nodiscard]] decltype(auto) sync_await(A &&awaitable) {
+[[nodiscard]] remove_rvalue_reference_t<await_result_t<A>> sync_await(A &&awaitable) {
     struct sync {
         std::binary_semaphore sem {0};
         void notify_awaitable_completed() { sem.release(); }
@@ -44,7 +47,7 @@ template <awaitable A>
     sync work_done;
     sync_task.start(work_done);
     work_done.sem.acquire();
-    return sync_task.get();
+    return std::move(sync_task).get();
 }
 
 } // namespace mp_coro
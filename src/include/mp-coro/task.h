@@ -22,7 +22,9 @@
 
 #pragma once
 
+#include <mp-coro/bits/frame_allocation.h>
 #include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/resumption_budget.h>
 #include <mp-coro/bits/task_promise_storage.h>
 #include <mp-coro/concepts.h>
 #include <mp-coro/coro_ptr.h>
@@ -71,7 +73,9 @@ class [[nodiscard]] task {
     /// value produced by the @ref task, and a handle to an optional
     /// continuation to execute
     /// @todo when exactly?
-    struct promise_type : private detail::noncopyable, detail::task_promise_storage<T> {
+    struct promise_type : private detail::noncopyable,
+                          detail::frame_allocation<promise_type>,
+                          detail::task_promise_storage<T> {
         std::coroutine_handle<> continuation = std::noop_coroutine();
 
         /// Returns a @ref task that references this promise.
@@ -88,10 +92,13 @@ class [[nodiscard]] task {
 
         /// Awaiter returned by @ref final_suspend.
         struct final_awaiter : std::suspend_always {
+            /// Queue node used if the continuation has to be yielded.
+            detail::work_item item;
+
             std::coroutine_handle<>
             await_suspend(std::coroutine_handle<promise_type> this_coro) noexcept {
                 TRACE_FUNC();
-                return this_coro.promise().continuation;
+                return detail::transfer_within_budget(this_coro.promise().continuation, item);
             }
         };
 
@@ -112,6 +119,9 @@ class [[nodiscard]] task {
         /// Reference to the promise object of the @ref task in question.
         promise_type &promise;
 
+        /// Queue node used if the @ref task's coroutine has to be yielded.
+        mutable detail::work_item item {};
+
         /// Returns true if the @ref task's coroutine is already done
         /// (suspended at its final suspension point).
         bool await_ready() const noexcept {
@@ -120,11 +130,13 @@ class [[nodiscard]] task {
         }
 
         /// Set the current coroutine as this @ref task's continuation, and then
-        /// resume this @ref task's coroutine.
+        /// resume this @ref task's coroutine (or yield it if the resumption
+        /// budget of the current worker is exhausted).
         std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) const noexcept {
             TRACE_FUNC();
             promise.continuation = h;
-            return std::coroutine_handle<promise_type>::from_promise(promise);
+            return detail::transfer_within_budget(
+                std::coroutine_handle<promise_type>::from_promise(promise), item);
         }
 
         /// Return the value of the @ref task's promise.
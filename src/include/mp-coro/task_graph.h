@@ -0,0 +1,202 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/async_scope.h>
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mp_coro {
+
+namespace detail {
+
+template <typename F>
+task<> invoke_node(F &fn) {
+    TRACE_FUNC();
+    if constexpr (awaitable<std::invoke_result_t<F &>>)
+        co_await std::invoke(fn);
+    else
+        std::invoke(fn);
+}
+
+} // namespace detail
+
+/// Directed acyclic graph of work items (nodes) with dependencies (edges)
+/// between them, executed on a scheduler with as much parallelism as the
+/// dependencies allow.
+///
+/// Every node has an atomic counter of its unfinished dependencies. When a
+/// node completes, it decrements the counters of its successors, and the
+/// nodes that drop to zero are released right away: the first one continues
+/// on the same thread, the others are scheduled. Unlike with nested
+/// @ref when_all() calls, a node that several others depend on (e.g. in a
+/// diamond) is neither awaited redundantly nor does it wait for unrelated
+/// work.
+///
+/// The graph is built once and can be run any number of times (one run at a
+/// time); the counters are reset at the start of each run.
+///
+/// If a node throws, the nodes that depend on it (directly or not) are
+/// skipped, the other ones still run, and the first exception is rethrown
+/// from the awaited @ref run().
+///
+/// @par Example
+///
+/// ```cpp
+/// task_graph graph;
+/// auto fetch = graph.add([&] { return fetch_rows(db); });  // returns a task<>
+/// auto index = graph.add([&] { build_index(); }, {fetch}); // plain function
+/// auto stats = graph.add([&] { compute_stats(); }, {fetch});
+/// graph.add([&] { return publish(); }, {index, stats});
+///
+/// task<> nightly(thread_pool &pool, task_graph &graph) {
+///     co_await graph.run(pool);
+/// }
+/// ```
+class task_graph : private detail::noncopyable {
+  public:
+    using node_id = std::size_t;
+
+    task_graph() = default;
+
+    /// Adds a node that runs @p fn, after all the @p dependencies complete.
+    /// If @p fn returns an awaitable (e.g. it is a coroutine returning a
+    /// @ref task), the node completes when that awaitable does.
+    /// @returns the identifier of the new node.
+    template <std::invocable F>
+        requires std::copy_constructible<F>
+    node_id add(F fn, std::initializer_list<node_id> dependencies = {}) {
+        const node_id id = nodes_.size();
+        if constexpr (std::same_as<std::invoke_result_t<F &>, task<>>)
+            nodes_.emplace_back(std::move(fn));
+        else
+            nodes_.emplace_back([fn = std::move(fn)]() mutable { return detail::invoke_node(fn); });
+        for (const node_id d : dependencies)
+            precede(d, id);
+        return id;
+    }
+
+    /// Adds a dependency: the node @p after will only start when @p before
+    /// completes.
+    void precede(node_id before, node_id after) {
+        assert(before < nodes_.size() && after < nodes_.size() && "unknown task_graph node");
+        nodes_[before].successors.push_back(after);
+        ++nodes_[after].dependency_count;
+        acyclic_ = false;
+    }
+
+    /// Number of nodes.
+    [[nodiscard]] std::size_t size() const noexcept { return nodes_.size(); }
+
+    /// Returns a @ref task that runs all the nodes on @p sched, and completes
+    /// when all of them do.
+    /// @throws std::logic_error (when awaited) if the dependencies make a
+    ///         cycle; nothing is run then.
+    /// @pre    The graph is neither modified nor run again until the
+    ///         returned task completes.
+    template <scheduler S>
+    [[nodiscard]] task<> run(S &sched) {
+        TRACE_FUNC();
+        if (!acyclic_) {
+            if (has_cycle())
+                throw std::logic_error("task_graph: the dependencies make a cycle");
+            acyclic_ = true;
+        }
+        for (node &n : nodes_)
+            n.pending.store(n.dependency_count, std::memory_order_relaxed);
+        async_scope scope;
+        for (node &n : nodes_)
+            if (n.dependency_count == 0)
+                scope.spawn(sched, run_from(sched, scope, &n));
+        co_await scope.join();
+    }
+
+  private:
+    struct node {
+        explicit node(std::function<task<>()> f) : fn(std::move(f)) {}
+
+        std::function<task<>()> fn;
+        std::vector<node_id> successors;
+        std::size_t dependency_count = 0;
+        std::atomic<std::size_t> pending = 0; // dependencies yet to complete in this run
+    };
+
+    /// Runs @p n and then all the successors it releases: the first one on
+    /// the current thread, the others spawned on @p sched.
+    template <scheduler S>
+    task<> run_from(S &sched, async_scope &scope, node *n) {
+        TRACE_FUNC();
+        while (n) {
+            co_await n->fn();
+            node *next = nullptr;
+            for (const node_id id : n->successors) {
+                node &s = nodes_[id];
+                if (s.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (next)
+                        scope.spawn(sched, run_from(sched, scope, &s));
+                    else
+                        next = &s;
+                }
+            }
+            n = next;
+        }
+    }
+
+    /// Kahn's algorithm: a cycle remains when the nodes without pending
+    /// dependencies are removed repeatedly.
+    bool has_cycle() const {
+        std::vector<std::size_t> pending(nodes_.size());
+        std::vector<node_id> ready;
+        for (node_id id = 0; id < nodes_.size(); ++id)
+            if ((pending[id] = nodes_[id].dependency_count) == 0)
+                ready.push_back(id);
+        std::size_t removed = 0;
+        while (!ready.empty()) {
+            const node_id id = ready.back();
+            ready.pop_back();
+            ++removed;
+            for (const node_id s : nodes_[id].successors)
+                if (--pending[s] == 0)
+                    ready.push_back(s);
+        }
+        return removed != nodes_.size();
+    }
+
+    std::deque<node> nodes_; // not a vector, as the nodes can't be moved
+    bool acyclic_ = true;
+};
+
+} // namespace mp_coro
@@ -0,0 +1,380 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/noncopyable.h>
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/numa.h>
+#include <mp-coro/trace.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace mp_coro {
+
+/// Priority of the coroutines scheduled on a @ref thread_pool.
+enum class priority : std::uint8_t { high, normal, low };
+
+/// Scheduler that resumes awaiting coroutines on a fixed set of worker threads.
+///
+/// Every worker owns a FIFO queue of suspended coroutines per @ref priority.
+/// Coroutines that are scheduled from one of the workers are pushed to that
+/// worker's queues, the others are distributed round-robin. Workers take the
+/// highest priority work available, first from their own queues and then by
+/// stealing from the other workers (those of the same NUMA node first), before
+/// going to sleep.
+///
+/// To prevent starvation, lower priorities age: every time a worker takes work
+/// of a higher priority while there is work of a lower priority pending, the
+/// lower priority is passed over once more, and after `aging_limit` passes the
+/// worker takes one of its coroutines first.
+///
+/// The queues are intrusive: their nodes are the awaiters returned by
+/// @ref schedule(), which live in the frame of the awaiting coroutine, so
+/// scheduling never allocates.
+///
+/// Every coroutine resumed by a worker gets a budget of symmetric transfers
+/// between tasks. Once it is used up, the next transfer yields to the back of
+/// the worker's queue at the same priority (see also @ref yield()), which
+/// bounds the time a chain of synchronously completing tasks can hold a
+/// worker.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<int> compute(thread_pool &pool) {
+///     co_await pool.schedule(); // continues on one of the workers
+///     co_return 42;
+/// }
+///
+/// task<> handle_request(thread_pool &pool) {
+///     co_await pool.schedule(priority::high); // jumps ahead of batch work
+///     // ...
+/// }
+/// ```
+class thread_pool : private detail::noncopyable {
+  public:
+    /// Awaiter returned by @ref schedule(). Also serves as the node of the
+    /// intrusive work queues.
+    class schedule_operation {
+      public:
+        schedule_operation(thread_pool &pool, mp_coro::priority p) noexcept
+            : pool_(pool), priority_(p) {}
+
+        static bool await_ready() noexcept {
+            TRACE_FUNC();
+            return false;
+        }
+
+        /// Enqueues the awaiting coroutine to be resumed by one of the workers.
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            TRACE_FUNC();
+            item_.handle = handle;
+            pool_.enqueue(&item_, static_cast<std::size_t>(priority_));
+        }
+
+        static void await_resume() noexcept { TRACE_FUNC(); }
+
+      private:
+        thread_pool &pool_;
+        mp_coro::priority priority_;
+        detail::work_item item_;
+    };
+
+    /// Starts @p thread_count worker threads (at least one).
+    /// @param  aging_limit      Number of times a pending lower priority can
+    ///                          be passed over before it is served first.
+    /// @param  resume_budget    Number of symmetric transfers a resumed
+    ///                          coroutine can make before it is preempted
+    ///                          (0 disables the preemption, but not
+    ///                          @ref yield()).
+    explicit thread_pool(std::size_t thread_count = std::thread::hardware_concurrency(),
+                         std::size_t aging_limit = 16, std::size_t resume_budget = 64)
+        : thread_pool(std::vector<worker_affinity>(std::max<std::size_t>(thread_count, 1)),
+                      aging_limit, resume_budget) {}
+
+    /// Starts a worker thread for every element of @p workers (at least one),
+    /// restricted to its CPUs and bound to its NUMA node (see
+    /// @ref numa_topology::place_workers()). With `MP_CORO_NUMA_FRAMES`, the
+    /// frames of the coroutines started on a worker are allocated from memory
+    /// local to its node.
+    explicit thread_pool(std::vector<worker_affinity> workers, std::size_t aging_limit = 16,
+                         std::size_t resume_budget = 64)
+        : queue_count_(std::max<std::size_t>(workers.size(), 1)),
+          aging_limit_(aging_limit),
+          resume_budget_(resume_budget ? resume_budget : std::numeric_limits<std::size_t>::max()),
+          queues_(std::make_unique<queue[]>(queue_count_)) {
+        workers.resize(queue_count_);
+        // steal from the same node first, then from the others
+        for (std::size_t i = 0; i < queue_count_; ++i) {
+            auto &victims = queues_[i].victims;
+            victims.reserve(queue_count_);
+            for (const bool same_node : {true, false})
+                for (std::size_t n = 0; n < queue_count_; ++n) {
+                    const std::size_t v = (i + n) % queue_count_;
+                    if ((workers[v].node == workers[i].node) == same_node)
+                        victims.push_back(v);
+                }
+        }
+        threads_.reserve(queue_count_);
+        for (std::size_t i = 0; i < queue_count_; ++i)
+            threads_.emplace_back(
+                [this, i, affinity = std::move(workers[i])](std::stop_token stop) {
+                    run(i, affinity, stop);
+                });
+    }
+
+    /// Lets the workers finish all the work that is still queued and joins
+    /// them.
+    ~thread_pool() {
+        for (auto &t : threads_)
+            t.request_stop();
+        threads_.clear();
+    }
+
+    /// Returns an awaitable that resumes the awaiting coroutine on one of the
+    /// worker threads.
+    [[nodiscard]] schedule_operation schedule(mp_coro::priority p = priority::normal) noexcept {
+        return schedule_operation {*this, p};
+    }
+
+    /// Enqueues the coroutines of all @p items to be resumed by the workers in
+    /// one batch: the items are split evenly between the queues of the
+    /// workers, taking each lock once, and no more workers are woken up than
+    /// there are items.
+    /// @note   The items are linked together, so they must stay alive (and
+    ///         untouched) until their coroutines are resumed.
+    void schedule_bulk(std::span<detail::work_item> items,
+                       mp_coro::priority p = priority::normal) {
+        if (items.empty())
+            return;
+        const auto lane = static_cast<std::size_t>(p);
+        pending_[lane].fetch_add(items.size());
+        const std::size_t chunk = (items.size() + queue_count_ - 1) / queue_count_;
+        const std::size_t first_queue = next_queue_.fetch_add(1, std::memory_order_relaxed);
+        for (std::size_t begin = 0, q = 0; begin < items.size(); begin += chunk, ++q) {
+            const std::size_t end = std::min(begin + chunk, items.size());
+            for (std::size_t i = begin; i + 1 < end; ++i)
+                items[i].next = &items[i + 1];
+            items[end - 1].next = nullptr;
+            queues_[(first_queue + q) % queue_count_].push(&items[begin], &items[end - 1],
+                                                           end - begin, lane);
+        }
+        wake_workers(items.size());
+    }
+
+    /// Number of worker threads.
+    [[nodiscard]] std::size_t thread_count() const noexcept { return queue_count_; }
+
+    /// Returns `true` if called on a worker whose queues are empty, i.e. when
+    /// other workers running out of work would have nothing to steal from it.
+    /// Splitting off work is worth it then (see @ref parallel_for_each()).
+    /// Always `false` on other threads.
+    [[nodiscard]] bool is_starving() const noexcept {
+        return current_worker_.pool == this &&
+               queues_[current_worker_.index].size.load(std::memory_order_relaxed) == 0;
+    }
+
+  private:
+    static constexpr std::size_t priority_count = 3;
+
+    /// Mutex-protected intrusive FIFOs (one per priority) of scheduled
+    /// coroutines owned by a single worker (and stolen from by the others).
+    struct alignas(64) queue {
+        struct lane {
+            detail::work_item *head = nullptr;
+            detail::work_item *tail = nullptr;
+        };
+
+        std::mutex mutex;
+        std::array<lane, priority_count> lanes;
+        /// How many times each priority was passed over; only accessed by the
+        /// owning worker.
+        std::array<std::size_t, priority_count> skipped {};
+        /// Queues the owning worker pops from, in order (its own one first).
+        std::vector<std::size_t> victims;
+        /// Number of items in all the lanes; modified under the lock, but
+        /// read without it by @ref is_starving().
+        std::atomic<std::size_t> size = 0;
+
+        /// Appends the chain of @p count items from @p first to @p last.
+        void push(detail::work_item *first, detail::work_item *last, std::size_t count,
+                  std::size_t p) {
+            std::lock_guard lock(mutex);
+            lane &l = lanes[p];
+            if (l.tail)
+                l.tail->next = first;
+            else
+                l.head = first;
+            l.tail = last;
+            size.store(size.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        detail::work_item *try_pop(std::size_t p) {
+            std::lock_guard lock(mutex);
+            lane &l = lanes[p];
+            detail::work_item *item = l.head;
+            if (item) {
+                l.head = item->next;
+                if (!l.head)
+                    l.tail = nullptr;
+                item->next = nullptr;
+                size.store(size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+    };
+
+    /// Resumption budget of a worker: preempted coroutines go back to the
+    /// queue of the worker with the priority they were resumed with.
+    class worker_budget final : public detail::resumption_budget {
+      public:
+        worker_budget(thread_pool &pool, std::size_t limit) noexcept
+            : resumption_budget(limit), pool_(pool) {}
+
+        std::size_t current_priority = 0; // of the coroutine being resumed
+
+        void yield(detail::work_item &item) noexcept override {
+            refill();
+            pool_.enqueue(&item, current_priority);
+        }
+
+      private:
+        thread_pool &pool_;
+    };
+
+    /// Identifies the worker running on the current thread (if any).
+    struct worker_id {
+        const thread_pool *pool;
+        std::size_t index;
+    };
+    static inline thread_local worker_id current_worker_ {};
+
+    bool has_pending() const noexcept {
+        return std::ranges::any_of(pending_, [](const auto &p) { return p.load() != 0; });
+    }
+
+    void enqueue(detail::work_item *item, std::size_t p) {
+        const std::size_t index = current_worker_.pool == this
+                                    ? current_worker_.index
+                                    : next_queue_.fetch_add(1, std::memory_order_relaxed)
+                                          % queue_count_;
+        // Counted before pushing so that the work can never be observed with a
+        // zero counter (the worst case is a spurious wake-up).
+        pending_[p].fetch_add(1);
+        queues_[index].push(item, item, 1, p);
+        wake_workers(1);
+    }
+
+    /// Wakes up to @p count sleeping workers.
+    void wake_workers(std::size_t count) {
+        count = std::min(count, sleeping_.load());
+        if (count == 0)
+            return;
+        { std::lock_guard lock(sleep_mutex_); }
+        if (count >= queue_count_)
+            sleep_cv_.notify_all();
+        else
+            while (count-- != 0)
+                sleep_cv_.notify_one();
+    }
+
+    /// Pops from the queues of priority @p p: own queue first, then steals
+    /// from the neighbours.
+    detail::work_item *try_pop_lane(std::size_t index, std::size_t p) {
+        if (pending_[p].load(std::memory_order_relaxed) == 0)
+            return nullptr;
+        for (const std::size_t victim : queues_[index].victims)
+            if (auto *item = queues_[victim].try_pop(p)) {
+                pending_[p].fetch_sub(1, std::memory_order_relaxed);
+                return item;
+            }
+        return nullptr;
+    }
+
+    /// @param[out] p   Priority of the returned work item.
+    detail::work_item *try_pop(std::size_t index, std::size_t &p) {
+        auto &skipped = queues_[index].skipped;
+        // aged lower priorities first (the lowest one is the most starved)
+        for (p = priority_count; p-- > 1;)
+            if (skipped[p] >= aging_limit_)
+                if (auto *item = try_pop_lane(index, p)) {
+                    skipped[p] = 0;
+                    return item;
+                }
+        for (p = 0; p < priority_count; ++p)
+            if (auto *item = try_pop_lane(index, p)) {
+                skipped[p] = 0;
+                for (std::size_t lower = p + 1; lower < priority_count; ++lower)
+                    if (pending_[lower].load(std::memory_order_relaxed) != 0)
+                        ++skipped[lower];
+                return item;
+            }
+        return nullptr;
+    }
+
+    void run(std::size_t index, const worker_affinity &affinity, std::stop_token stop) {
+        detail::bind_current_thread(affinity);
+        current_worker_ = worker_id {this, index};
+        worker_budget budget(*this, resume_budget_);
+        detail::resumption_budget::scope budget_scope(&budget);
+        while (true) {
+            if (auto *item = try_pop(index, budget.current_priority)) {
+                budget.refill();
+                item->handle.resume();
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex_);
+            sleeping_.fetch_add(1);
+            sleep_cv_.wait(lock, stop, [&] { return has_pending(); });
+            sleeping_.fetch_sub(1);
+            if (stop.stop_requested() && !has_pending())
+                break;
+        }
+        current_worker_ = worker_id {};
+    }
+
+    const std::size_t queue_count_;
+    const std::size_t aging_limit_;
+    const std::size_t resume_budget_;
+    std::unique_ptr<queue[]> queues_;
+    std::atomic<std::size_t> next_queue_ = 0;
+    std::array<std::atomic<std::size_t>, priority_count> pending_ {};
+    std::atomic<std::size_t> sleeping_ = 0;
+    std::mutex sleep_mutex_;
+    std::condition_variable_any sleep_cv_;
+    std::vector<std::jthread> threads_; // must be the last member (joined first)
+};
+
+} // namespace mp_coro
@@ -0,0 +1,181 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/get_awaiter.h>
+#include <mp-coro/concepts.h>
+#include <mp-coro/task.h>
+#include <mp-coro/trace.h>
+#include <mp-coro/type_traits.h>
+#include <concepts>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mp_coro {
+
+/// Awaitable result of an asynchronous operation that often completes
+/// synchronously: holds either the value right away, or a @ref task that
+/// produces it.
+///
+/// Functions that return a @ref value_task are regular functions (not
+/// coroutines), so the ready path (e.g. a cache hit) costs no coroutine frame
+/// allocation, and awaiting it does not suspend the awaiting coroutine
+/// (`await_ready()` returns `true`). Otherwise, awaiting a @ref value_task is
+/// the same as awaiting the wrapped @ref task.
+///
+/// @par Example
+///
+/// ```cpp
+/// task<std::string> fetch(int key);
+///
+/// value_task<std::string> lookup(int key) {
+///     if (auto it = cache.find(key); it != cache.end())
+///         return it->second; // no allocation
+///     return fetch(key);
+/// }
+///
+/// task<> foo() {
+///     std::string value = co_await lookup(42);
+/// }
+/// ```
+///
+/// @ingroup coro_ret_types
+template <task_value_type T = void>
+class [[nodiscard]] value_task {
+    using ready_type =
+        std::conditional_t<std::is_void_v<T>, std::monostate,
+                           std::conditional_t<std::is_reference_v<T>,
+                                              std::add_pointer_t<std::remove_reference_t<T>>, T>>;
+    using lvalue_result_type = std::conditional_t<std::is_void_v<T> || std::is_reference_v<T>, T,
+                                                  std::add_lvalue_reference_t<const T>>;
+    using rvalue_result_type = std::add_rvalue_reference_t<T>;
+
+  public:
+    /// The type of the value produced by this @ref value_task.
+    using value_type = T;
+
+    /// Ready @ref value_task holding @p value.
+    template <std::convertible_to<T> U>
+    requires(!std::is_reference_v<T>) && (!std::same_as<std::remove_cvref_t<U>, value_task>)
+    value_task(U &&value) : state_(std::in_place_index<0>, std::forward<U>(value)) {
+        TRACE_FUNC();
+    }
+
+    /// Ready @ref value_task referring to @p value.
+    template <std::same_as<T> U = T>
+    requires std::is_reference_v<U> value_task(std::type_identity_t<U> value) noexcept
+        : state_(std::in_place_index<0>, std::addressof(value)) {
+        TRACE_FUNC();
+    }
+
+    /// Ready @ref value_task of `void`.
+    value_task() noexcept requires std::is_void_v<T> : state_(std::in_place_index<0>) {
+        TRACE_FUNC();
+    }
+
+    /// @ref value_task that produces its value by awaiting @p t.
+    value_task(task<T> &&t) noexcept : state_(std::in_place_index<1>, std::move(t)) {
+        TRACE_FUNC();
+    }
+
+    value_task(value_task &&) = default;           ///< Move constructor.
+    value_task &operator=(value_task &&) = delete; ///< Move assignment not allowed.
+
+    /// Returns true if the value is held inline (no @ref task is involved).
+    [[nodiscard]] bool is_ready() const noexcept { return state_.index() == 0; }
+
+  private:
+    struct awaiter_base {
+        using task_awaiter_type = std::remove_cvref_t<awaiter_for_t<const task<T> &>>;
+
+        const value_task &self;
+
+        /// The awaiter of the wrapped @ref task, kept until the awaiting
+        /// coroutine is resumed (its queue node may be in use until then).
+        mutable std::optional<task_awaiter_type> suspended = std::nullopt;
+
+        decltype(auto) task_awaiter() const noexcept {
+            return detail::get_awaiter(std::get<1>(self.state_));
+        }
+
+        /// Returns true if the value is held inline or the @ref task is
+        /// already done.
+        bool await_ready() const noexcept {
+            TRACE_FUNC();
+            return self.is_ready() || task_awaiter().await_ready();
+        }
+
+        /// Awaits the wrapped @ref task (only called on the non-ready path).
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) const noexcept {
+            TRACE_FUNC();
+            return suspended.emplace(task_awaiter()).await_suspend(h);
+        }
+    };
+
+  public:
+    /// Returns the inline value or awaits the wrapped @ref task.
+    awaiter_of<lvalue_result_type> auto operator co_await() const &noexcept {
+        TRACE_FUNC();
+        struct awaiter : awaiter_base {
+            lvalue_result_type await_resume() const {
+                TRACE_FUNC();
+                if (!this->self.is_ready())
+                    return this->task_awaiter().await_resume();
+                if constexpr (std::is_reference_v<T>)
+                    return *std::get<0>(this->self.state_);
+                else if constexpr (!std::is_void_v<T>)
+                    return std::get<0>(this->self.state_);
+            }
+        };
+        return awaiter {{*this}};
+    }
+
+    /// @copydoc operator co_await()const&
+    awaiter_of<rvalue_result_type> auto operator co_await() const &&noexcept {
+        TRACE_FUNC();
+        struct awaiter : awaiter_base {
+            rvalue_result_type await_resume() const {
+                TRACE_FUNC();
+                if (!this->self.is_ready())
+                    return detail::get_awaiter(std::move(std::get<1>(this->self.state_)))
+                        .await_resume();
+                if constexpr (std::is_reference_v<T>)
+                    return *std::get<0>(this->self.state_);
+                else if constexpr (!std::is_void_v<T>)
+                    return std::move(std::get<0>(this->self.state_));
+            }
+        };
+        return awaiter {{*this}};
+    }
+
+  private:
+    /// Mutable as the result of a @ref task is (it lives behind a pointer to
+    /// the promise), so that awaiting an rvalue can move from it.
+    mutable std::variant<ready_type, task<T>> state_;
+};
+
+} // namespace mp_coro
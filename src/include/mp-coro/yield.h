@@ -0,0 +1,77 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/bits/resumption_budget.h>
+#include <mp-coro/trace.h>
+#include <coroutine>
+
+namespace mp_coro {
+
+/// Awaiter returned by @ref yield().
+class yield_operation {
+  public:
+    /// Does not suspend when not running on a worker with a resumption
+    /// budget (e.g. of a @ref thread_pool).
+    static bool await_ready() noexcept {
+        TRACE_FUNC();
+        return detail::resumption_budget::current() == nullptr;
+    }
+
+    /// Moves the awaiting coroutine to the back of the queue of the current
+    /// worker.
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+        TRACE_FUNC();
+        item_.handle = handle;
+        detail::resumption_budget::current()->yield(item_);
+    }
+
+    static void await_resume() noexcept { TRACE_FUNC(); }
+
+  private:
+    detail::work_item item_;
+};
+
+/// Returns an awaitable that lets the other coroutines queued on the current
+/// worker run before the awaiting coroutine continues, e.g. in long
+/// computations that do not suspend otherwise. It does not allocate, and it
+/// completes immediately when not running on a worker of a scheduler that
+/// supports cooperative preemption.
+///
+/// Tasks also yield automatically once they exhaust the resumption budget of
+/// the worker (see the @ref thread_pool constructor).
+///
+/// @par Example
+///
+/// ```cpp
+/// task<> crunch(thread_pool &pool, std::span<block> blocks) {
+///     co_await pool.schedule();
+///     for (auto &b : blocks) {
+///         process(b);
+///         co_await yield();
+///     }
+/// }
+/// ```
+[[nodiscard]] inline yield_operation yield() noexcept { return {}; }
+
+} // namespace mp_coro
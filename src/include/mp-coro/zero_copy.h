@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2021 Mateusz Pusz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <mp-coro/blocking_pool.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace mp_coro {
+
+namespace detail {
+
+/// Calls @p transfer until it is not interrupted by a signal.
+template <typename F>
+std::size_t transfer_bytes(F transfer, const char *what) {
+    while (true) {
+        const auto n = transfer();
+        if (n >= 0)
+            return static_cast<std::size_t>(n);
+        if (errno != EINTR)
+            throw std::system_error(errno, std::system_category(), what);
+    }
+}
+
+} // namespace detail
+
+/// @ingroup zero_copy
+///
+/// Returns an awaitable that sends up to @p count bytes of the file @p in,
+/// from @p in_offset, to @p out with `sendfile()`.
+[[nodiscard]] inline auto async_sendfile(int out, int in, std::optional<std::uint64_t> in_offset,
+                                         std::size_t count,
+                                         blocking_pool &pool = blocking_pool::global()) {
+    return async_blocking(pool, [=] {
+        ::off_t offset = static_cast<::off_t>(in_offset.value_or(0));
+        return detail::transfer_bytes(
+            [&] { return ::sendfile(out, in, in_offset ? &offset : nullptr, count); },
+            "sendfile");
+    });
+}
+
+/// @ingroup zero_copy
+///
+/// Returns an awaitable that moves up to @p length bytes from @p in to
+/// @p out with `splice()`. One of the descriptors must be a pipe (with no
+/// offset).
+[[nodiscard]] inline auto async_splice(int in, std::optional<std::uint64_t> in_offset, int out,
+                                       std::optional<std::uint64_t> out_offset,
+                                       std::size_t length, unsigned flags = SPLICE_F_MOVE,
+                                       blocking_pool &pool = blocking_pool::global()) {
+    return async_blocking(pool, [=] {
+        ::loff_t in_off = static_cast<::loff_t>(in_offset.value_or(0));
+        ::loff_t out_off = static_cast<::loff_t>(out_offset.value_or(0));
+        return detail::transfer_bytes(
+            [&] {
+                return ::splice(in, in_offset ? &in_off : nullptr, out,
+                                out_offset ? &out_off : nullptr, length, flags);
+            },
+            "splice");
+    });
+}
+
+/// @ingroup zero_copy
+///
+/// Returns an awaitable that copies up to @p length bytes between the files
+/// @p in and @p out with `copy_file_range()`.
+[[nodiscard]] inline auto async_copy_file_range(int in, std::optional<std::uint64_t> in_offset,
+                                                int out, std::optional<std::uint64_t> out_offset,
+                                                std::size_t length,
+                                                blocking_pool &pool = blocking_pool::global()) {
+    return async_blocking(pool, [=] {
+        ::loff_t in_off = static_cast<::loff_t>(in_offset.value_or(0));
+        ::loff_t out_off = static_cast<::loff_t>(out_offset.value_or(0));
+        return detail::transfer_bytes(
+            [&] {
+                return ::copy_file_range(in, in_offset ? &in_off : nullptr, out,
+                                         out_offset ? &out_off : nullptr, length, 0);
+            },
+            "copy_file_range");
+    });
+}
+
+} // namespace mp_coro